@@ -0,0 +1,158 @@
+#include <memory>
+#include <vector>
+#include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <cstring>
+
+#include <rlottie.h>
+
+static bool isJsonFile(const char *filename) {
+  const char *dot = strrchr(filename, '.');
+  if(!dot || dot == filename) return false;
+  return !strcmp(dot + 1, "json");
+}
+
+struct Resource
+{
+    std::string                         name;
+    std::unique_ptr<rlottie::Animation> animation;
+    size_t                              keyframes{0};
+};
+
+static void
+addResource(std::vector<Resource> &result, const std::string &path, const char *name)
+{
+    auto animation = rlottie::Animation::loadFromFile(path, false);
+    if (!animation || animation->totalFrame() < 2) return;
+    auto keyframes = animation->memoryStats().keyframes;
+    result.push_back({name, std::move(animation), keyframes});
+}
+
+static std::vector<Resource>
+keyframeResources(const std::string &dirName, const std::vector<std::string> &files, size_t count)
+{
+    std::vector<Resource> result;
+    for (const auto &e : files) addResource(result, e, e.c_str());
+    if (!result.empty()) return result;
+
+    DIR *d;
+    struct dirent *dir;
+    d = opendir(dirName.c_str());
+    if (d) {
+      while ((dir = readdir(d)) != NULL) {
+        if (isJsonFile(dir->d_name)) addResource(result, dirName + dir->d_name, dir->d_name);
+      }
+      closedir(d);
+    }
+
+    // the resources holding the most keyframe data first.
+    std::sort(result.begin(), result.end(), [](auto & a, auto &b){return a.keyframes > b.keyframes;});
+    if (result.size() > count) result.resize(count);
+
+    return result;
+}
+
+/*
+ * Evaluates the animated properties of the keyframe densest resources.
+ * renderTree() updates the layer tree without rasterizing it, so the time
+ * is spent on keyframe lookup, easing and path building. The sequential
+ * pass is normal playback, the scattered one seeks across the animation
+ * on every frame.
+ */
+class KeyFramePerfTest
+{
+public:
+    explicit KeyFramePerfTest(const std::vector<std::string> &files, size_t resourceCount, size_t iterations):
+        _iterations(iterations)
+    {
+        _resources = keyframeResources(std::string(DEMO_DIR), files, resourceCount);
+    }
+    void test()
+    {
+        std::cout<<" Test Started : .... \n";
+        std::cout<< " \nKeyframe Evaluation Report: \n\n";
+        double sequential = 0, scattered = 0;
+        size_t frames = 0;
+        for (auto &e : _resources) {
+            auto total = e.animation->totalFrame();
+            auto seq = run(e, total, 1);
+            // a stride coprime with the frame count visits every frame.
+            size_t stride = total / 2 + 1;
+            while (gcd(stride, total) != 1) stride++;
+            auto scat = run(e, total, stride);
+            sequential += seq;
+            scattered += scat;
+            frames += total * _iterations;
+            std::cout<< " \t "<< e.name <<" ("<< e.keyframes / 1024 <<"KB keyframes) : sequential "
+                     << seq * 1000 / (total * _iterations) <<"us, scattered "
+                     << scat * 1000 / (total * _iterations) <<"us per frame\n";
+        }
+        std::cout<< " \n \t Resources                   : "<< _resources.size() <<"\n";
+        std::cout<< " \t Iterations                  : "<< _iterations <<"\n";
+        if (frames) {
+            std::cout<< " \t Avrage Sequential Frame     : "<< sequential * 1000 / frames <<"us\n";
+            std::cout<< " \t Avrage Scattered Frame      : "<< scattered * 1000 / frames <<"us\n";
+        }
+        std::cout<< " Test Finished.\n\n";
+    }
+private:
+    static size_t gcd(size_t a, size_t b) { return b ? gcd(b, a % b) : a; }
+
+    double run(Resource &resource, size_t total, size_t stride)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t frame = 0;
+        for (auto i = 0u; i < _iterations; i++) {
+            for (auto j = 0u; j < total; j++) {
+                resource.animation->renderTree(frame, 100, 100);
+                frame = (frame + stride) % total;
+            }
+        }
+        std::chrono::duration<double, std::milli> millisecs = std::chrono::high_resolution_clock::now() - start;
+        return millisecs.count();
+    }
+
+private:
+    size_t  _iterations;
+
+    std::vector<Resource>   _resources;
+};
+
+static int help()
+{
+    std::cout<<"\nUsage : ./keyframeperf [-c] [resource count] [-i] [iteration count] [files] \n";
+    std::cout<<"\nExample : ./keyframeperf -c 5 -i 20 \n";
+    std::cout<<"\n\t evaluates every frame of the 5 keyframe densest resources 20 times\n";
+    std::cout<<"\t files given on the command line are used instead of the demo resources\n\n";
+    return 0;
+}
+int
+main(int argc, char ** argv)
+{
+    size_t resourceCount = 10;
+    size_t iterations = 20;
+    std::vector<std::string> files;
+    auto index = 1;
+
+    while (index < argc) {
+      const char* option = argv[index];
+      index++;
+      if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
+          return help();
+      } else if (!strcmp(option,"-c")) {
+         resourceCount = (index < argc) ? atoi(argv[index]) : resourceCount;
+         index++;
+      } else if (!strcmp(option,"-i")) {
+         iterations = (index < argc) ? atoi(argv[index]) : iterations;
+         index++;
+      } else {
+         files.push_back(option);
+      }
+   }
+
+    KeyFramePerfTest obj(files, resourceCount, iterations);
+    obj.test();
+    return 0;
+}
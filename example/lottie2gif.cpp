@@ -27,7 +27,7 @@ public:
     {
         GifEnd(&handle);
     }
-    void addFrame(rlottie::Surface &s, uint32_t delay = 2)
+    void addFrame(const rlottie::Surface &s, uint32_t delay = 2)
     {
         argbTorgba(s);
         GifWriteFrame(&handle,
@@ -36,7 +36,7 @@ public:
                       s.height(),
                       delay);
     }
-    void argbTorgba(rlottie::Surface &s)
+    void argbTorgba(const rlottie::Surface &s)
     {
         uint8_t *buffer = reinterpret_cast<uint8_t *>(s.buffer());
         uint32_t totalBytes = s.height() * s.bytesPerLine();
@@ -82,15 +82,21 @@ public:
         auto player = rlottie::Animation::loadFromFile(fileName);
         if (!player) return help();
 
-        auto buffer = std::unique_ptr<uint32_t[]>(new uint32_t[w * h]);
+        // a few buffers let the next frames render while one is encoded.
+        std::array<std::unique_ptr<uint32_t[]>, 4> buffers;
+        std::vector<rlottie::Surface> surfaces;
+        for (auto &buffer : buffers) {
+            buffer = std::unique_ptr<uint32_t[]>(new uint32_t[w * h]);
+            surfaces.emplace_back(buffer.get(), w, h, w * 4);
+        }
         size_t frameCount = player->totalFrame();
+        if (!frameCount) return result();
 
         GifBuilder builder(gifName.data(), w, h, bgColor);
-        for (size_t i = 0; i < frameCount ; i++) {
-            rlottie::Surface surface(buffer.get(), w, h, w * 4);
-            player->renderSync(i, surface);
-            builder.addFrame(surface);
-        }
+        player->renderRange(0, frameCount - 1, surfaces,
+                            [&builder](size_t, const rlottie::Surface &surface) {
+                                builder.addFrame(surface);
+                            });
         return result();
     }
 
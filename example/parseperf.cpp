@@ -0,0 +1,133 @@
+#include <memory>
+#include <vector>
+#include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+
+#include <rlottie.h>
+
+static bool isJsonFile(const char *filename) {
+  const char *dot = strrchr(filename, '.');
+  if(!dot || dot == filename) return false;
+  return !strcmp(dot + 1, "json");
+}
+
+struct Resource
+{
+    std::string name;
+    std::string data;
+    double      millisecs{0};
+};
+
+static std::vector<Resource>
+jsonResources(const std::string &dirName)
+{
+    DIR *d;
+    struct dirent *dir;
+    std::vector<Resource> result;
+    d = opendir(dirName.c_str());
+    if (d) {
+      while ((dir = readdir(d)) != NULL) {
+        if (!isJsonFile(dir->d_name)) continue;
+        std::ifstream file(dirName + dir->d_name, std::ios::binary);
+        std::stringstream content;
+        content << file.rdbuf();
+        result.push_back({dir->d_name, content.str()});
+      }
+      closedir(d);
+    }
+
+    // largest first, those are the path heavy ones.
+    std::sort(result.begin(), result.end(), [](auto & a, auto &b){return a.data.size() > b.data.size();});
+
+    return result;
+}
+
+class ParsePerfTest
+{
+public:
+    explicit ParsePerfTest(size_t iterations, size_t reportCount):
+        _iterations(iterations), _reportCount(reportCount)
+    {
+        _resources = jsonResources(std::string(DEMO_DIR));
+    }
+    void test()
+    {
+        std::cout<<" Test Started : .... \n";
+        size_t bytes = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto i = 0u; i < _iterations; i++) {
+            for (auto &e : _resources) bytes += parse(e);
+        }
+        std::chrono::duration<double> secs = std::chrono::high_resolution_clock::now() - start;
+        std::cout<< " Test Finished.\n";
+        std::cout<< " \nParse Performance Report: \n\n";
+        std::cout<< " \t Resources Parsed            : "<< _resources.size() <<"\n";
+        std::cout<< " \t Iterations                  : "<< _iterations <<"\n";
+        std::cout<< " \t Total Parse Time            : "<< secs.count()<<"sec\n";
+        std::cout<< " \t Throughput                  : "<< bytes / secs.count() / (1024 * 1024) <<"MB/s\n\n";
+
+        auto count = std::min(_reportCount, _resources.size());
+        if (count) std::cout<< " \t Largest Resources : \n";
+        for (auto i = 0u; i < count; i++) {
+            const auto &e = _resources[i];
+            auto ms = e.millisecs / _iterations;
+            std::cout<< " \t\t "<< e.name <<" ("<< e.data.size() / 1024 <<"KB) : "
+                     << ms <<"ms, "<< e.data.size() / ms / 1024 / 1024 * 1000 <<"MB/s\n";
+        }
+        std::cout<<"\n";
+    }
+private:
+    size_t parse(Resource &resource)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        // no caching, every iteration runs the parser.
+        auto animation = rlottie::Animation::loadFromData(resource.data, "", "", false);
+        std::chrono::duration<double, std::milli> millisecs = std::chrono::high_resolution_clock::now() - start;
+        resource.millisecs += millisecs.count();
+        return animation ? resource.data.size() : 0;
+    }
+
+private:
+    size_t  _iterations;
+    size_t  _reportCount;
+
+    std::vector<Resource>   _resources;
+};
+
+static int help()
+{
+    std::cout<<"\nUsage : ./parseperf [-i] [iteration count] [-n] [report count] \n";
+    std::cout<<"\nExample : ./parseperf -i 20 -n 5 \n";
+    std::cout<<"\n\t parses every resource 20 times and reports the 5 largest ones\n\n";
+    return 0;
+}
+int
+main(int argc, char ** argv)
+{
+    size_t iterations = 20;
+    size_t reportCount = 10;
+    auto index = 0;
+
+    while (index < argc) {
+      const char* option = argv[index];
+      index++;
+      if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
+          return help();
+      } else if (!strcmp(option,"-i")) {
+         iterations = (index < argc) ? atoi(argv[index]) : iterations;
+         index++;
+      } else if (!strcmp(option,"-n")) {
+         reportCount = (index < argc) ? atoi(argv[index]) : reportCount;
+         index++;
+      }
+   }
+
+    ParsePerfTest obj(iterations, reportCount);
+    obj.test();
+    return 0;
+}
@@ -23,7 +23,9 @@
 #ifndef _RLOTTIE_H_
 #define _RLOTTIE_H_
 
+#include <functional>
 #include <future>
+#include <iosfwd>
 #include <vector>
 #include <memory>
 
@@ -42,6 +44,7 @@
 #endif
 
 class AnimationImpl;
+struct RenderTask;
 struct LOTNode;
 struct LOTLayerNode;
 
@@ -64,6 +67,184 @@ namespace rlottie {
  */
 RLOTTIE_API void configureModelCacheSize(size_t cacheSize);
 
+/**
+ *  @brief Configures the memory budget of the model cache.
+ *
+ *  The least recently used models are evicted once the models in the
+ *  cache take more than @p bytes. The size of a model includes its
+ *  animation data and its decoded images.
+ *
+ *  @param[in] bytes  Maximum memory held by the cache, 0 only limits the
+ *                    number of models (@see configureModelCacheSize()).
+ *
+ *  @note a model bigger than the budget is not cached.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureModelCacheBudget(size_t bytes);
+
+/**
+ *  @brief Counters of the model cache.
+ *
+ *  @see modelCacheStats()
+ *  @internal
+ */
+struct ModelCacheStats {
+    size_t hits{0};       /* lookups served from the cache */
+    size_t misses{0};     /* lookups that had to parse the resource */
+    size_t coalesced{0};  /* lookups that waited for a parse in progress */
+    size_t evictions{0};  /* models dropped to honour the limits */
+    size_t entries{0};    /* models currently cached */
+    size_t bytes{0};      /* memory held by the cached models */
+};
+
+/**
+ *  @brief Returns the counters of the model cache.
+ *
+ *  The counters accumulate for the lifetime of the process.
+ *
+ *  @internal
+ */
+RLOTTIE_API ModelCacheStats modelCacheStats();
+
+/**
+ *  @brief Memory held by animations, in bytes.
+ *
+ *  The model fields describe the parsed resource, the renderer fields the
+ *  state kept to render it.
+ *
+ *  @see Animation::memoryStats()
+ *  @see memoryStats()
+ *  @internal
+ */
+struct MemoryStats {
+    size_t keyframes{0};   /* keyframes of the animated properties */
+    size_t paths{0};       /* path points, static and animated */
+    size_t modelArena{0};  /* arena blocks holding the model objects */
+    size_t images{0};      /* decoded images */
+    size_t fonts{0};       /* font entries and glyph outlines */
+    size_t model{0};       /* whole model, including the fields above */
+    size_t rles{0};        /* rasterized spans of the shapes, masks, clips */
+    size_t surfaces{0};    /* offscreen bitmaps kept for reuse */
+    size_t renderTree{0};  /* nodes of the renderTree() api */
+    size_t frameCache{0};  /* frames kept by Animation::setFrameCacheSize() */
+    size_t renderer{0};    /* whole renderer, including the fields above */
+    size_t total{0};       /* model + renderer */
+};
+
+/**
+ *  @brief Returns the memory held by the library.
+ *
+ *  Sums the renderers of every live Animation object and the models they
+ *  use or the model cache holds, each model counted once.
+ *
+ *  @note walks every live animation, meant for diagnostics and for
+ *        choosing the cache budgets, not to be called every frame.
+ *
+ *  @see configureModelCacheBudget()
+ *  @internal
+ */
+RLOTTIE_API MemoryStats memoryStats();
+
+/**
+ *  @brief Releases the decoded images of every model.
+ *
+ *  Images are decoded the first time their layer gets drawn and kept
+ *  for the next frames. Call this api under memory pressure, the images
+ *  get decoded again when they are drawn the next time.
+ *
+ *  @note images loaded from a precompiled file are stored decoded and
+ *        are not released. Render trees obtained before the call may
+ *        point to the released images until they are rebuilt.
+ *
+ *  @see Animation::toBinary()
+ *  @internal
+ */
+RLOTTIE_API void releaseDecodedImages();
+
+/**
+ *  @brief Configures the worker threads used by asynchronous rendering.
+ *
+ *  Animation::render() queues the frame on a pool of render threads
+ *  which steal work from each other's queue. This api lets the
+ *  application choose the size of that pool and the name given to its
+ *  threads.
+ *
+ *  @param[in] threadCount  Number of render threads, 0 uses the number of
+ *                          hardware threads.
+ *  @param[in] threadName   Prefix of the thread names, each thread gets
+ *                          its index appended (ex: "lottie-rnd-0").
+ *
+ *  @note must be called before the first Animation::render() call, once
+ *        the render threads are running the configuration is ignored.
+ *  @note has no effect when the library is built without thread support.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureRenderThreads(size_t threadCount,
+                                        const std::string &threadName = "lottie-rnd");
+
+/**
+ *  @brief Configures the worker threads used while rendering a frame.
+ *
+ *  The paths of a frame are rasterized, and the frame is blended in
+ *  bands (@see Animation::setRenderBands), by two pools of worker
+ *  threads. This api sets the size of both pools.
+ *
+ *  @param[in] threadCount  Number of threads of each pool, 0 uses the
+ *                          number of hardware threads.
+ *
+ *  @note must be called before the first render, once the threads are
+ *        running the configuration is ignored.
+ *  @note has no effect when the library is built without thread support.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureRasterThreads(size_t threadCount);
+
+/**
+ *  @brief Pins the worker threads of rlottie to a set of cpus.
+ *
+ *  The n-th thread of each pool runs on cpus[n % cpus.size()].
+ *
+ *  @param[in] cpus  cpu indices, empty lets the system schedule the
+ *                   threads.
+ *
+ *  @note must be called before the first render, it applies to the
+ *        threads created afterwards.
+ *  @note only supported on linux.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureThreadAffinity(std::vector<int> cpus);
+
+/**
+ *  @brief Callback that runs a task on the application's thread pool.
+ *
+ *  The executor must call @p task exactly once, on any thread. rlottie
+ *  never blocks a task waiting for another task that didn't start, so
+ *  any number of executor threads works.
+ *
+ *  @internal
+ */
+using Executor = std::function<void(std::function<void()> task)>;
+
+/**
+ *  @brief Runs the render, blending and rasterization tasks on the
+ *         application's executor instead of rlottie's own threads.
+ *
+ *  The thread pools of rlottie are not created while an executor is set.
+ *  The priority of Animation::requestRender() is left to the executor.
+ *
+ *  @param[in] executor  executor of the tasks, nullptr goes back to the
+ *                       rlottie threads.
+ *
+ *  @note has no effect when the library is built without thread support.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureExecutor(Executor executor);
+
 struct Color {
     Color() = default;
     Color(float r, float g , float b):_r(r), _g(g), _b(b){}
@@ -96,6 +277,21 @@ private:
     float _y{0};
 };
 
+struct Rect {
+    Rect() = default;
+    Rect(size_t x, size_t y, size_t w, size_t h):_x(x), _y(y), _w(w), _h(h){}
+    size_t x() const {return _x;}
+    size_t y() const {return _y;}
+    size_t w() const {return _w;}
+    size_t h() const {return _h;}
+    bool empty() const {return !_w || !_h;}
+private:
+    size_t _x{0};
+    size_t _y{0};
+    size_t _w{0};
+    size_t _h{0};
+};
+
 struct FrameInfo {
     explicit FrameInfo(uint32_t frame): _frameNo(frame){}
     uint32_t curFrame() const {return _frameNo;}
@@ -268,6 +464,160 @@ using LayerInfoList = std::vector<std::tuple<std::string, int , int>>;
 
 using ColorFilter = std::function<void(float &r , float &g, float &b)>;
 
+/**
+ *  @brief Scheduling priority of a render request.
+ *
+ *  Pending requests with a higher priority are rendered first.
+ *
+ *  @see Animation::requestRender()
+ *  @internal
+ */
+enum class RenderPriority : unsigned char {
+    Low,
+    Normal,
+    High
+};
+
+/**
+ *  @brief Handle of an asynchronous render started by
+ *         Animation::requestRender().
+ *
+ *  Copies of a handle refer to the same request.
+ *
+ *  @internal
+ */
+class RLOTTIE_API RenderRequest {
+public:
+    /**
+     *  @brief Constructs an empty handle.
+     *
+     *  @internal
+     */
+    RenderRequest() = default;
+
+    /**
+     *  @brief Checks whether the handle refers to a request.
+     *
+     *  @internal
+     */
+    bool valid() const;
+
+    /**
+     *  @brief Cancels the request.
+     *
+     *  A request still waiting in the queue is dropped and its result is
+     *  ready at once. A request being rendered stops before drawing into
+     *  the surface if it didn't reach that point yet, the rasterization
+     *  work it queued is dropped too.
+     *
+     *  @return false if the request already finished.
+     *
+     *  @note the content of the surface is undefined when the frame was
+     *        not drawn, see cancelled().
+     *  @internal
+     */
+    bool cancel();
+
+    /**
+     *  @brief Checks whether the frame was not drawn because the request
+     *         got cancelled.
+     *
+     *  @note the result is final once the request is ready, see get().
+     *  @internal
+     */
+    bool cancelled() const;
+
+    /**
+     *  @brief Returns the priority the request was scheduled with.
+     *
+     *  @internal
+     */
+    RenderPriority priority() const;
+
+    /**
+     *  @brief Waits for the request to finish.
+     *
+     *  @return the surface passed to Animation::requestRender().
+     *
+     *  @internal
+     */
+    Surface get() const;
+
+private:
+    friend class Animation;
+    RenderRequest(std::shared_ptr<RenderTask> task,
+                  std::shared_future<Surface> result);
+
+    std::shared_ptr<RenderTask> d;
+    std::shared_future<Surface> mResult;
+};
+
+/**
+ *  @brief Independent renderer of an Animation.
+ *
+ *  A RenderContext owns its own render tree but shares the parsed
+ *  animation data with the Animation it was created from. Each context
+ *  can render one frame at a time, so a set of contexts can render
+ *  different frames of the same Animation in parallel.
+ *
+ *  @see Animation::createRenderContext()
+ *  @internal
+ */
+class RLOTTIE_API RenderContext {
+public:
+    /**
+     *  @brief Renders the content to surface Asynchronously.
+     *
+     *  @see Animation::render()
+     *  @internal
+     */
+    std::future<Surface> render(size_t frameNo, Surface surface, bool keepAspectRatio=true);
+
+    /**
+     *  @brief Renders the content to surface synchronously.
+     *
+     *  @see Animation::renderSync()
+     *  @internal
+     */
+    bool renderSync(size_t frameNo, Surface surface, bool keepAspectRatio=true);
+
+    /**
+     *  @brief default destructor
+     *
+     *  @internal
+     */
+    ~RenderContext();
+
+    RenderContext(const RenderContext &) = delete;
+    RenderContext &operator=(const RenderContext &) = delete;
+
+private:
+    friend class Animation;
+    explicit RenderContext(std::unique_ptr<AnimationImpl> impl);
+
+    std::unique_ptr<AnimationImpl> d;
+};
+
+/**
+ *  @brief Options of a load.
+ *
+ *  @see Animation::loadFromFile()
+ *  @internal
+ */
+struct LoadOptions {
+    /* whether to cache or not the model data, see loadFromFile(). */
+    bool cachePolicy{true};
+    /*
+     * drops the object names, the markers, the assets no layer uses and
+     * the fonts when no layer draws text. The animation renders the same,
+     * but setValue() keypaths naming objects match nothing, markers() is
+     * empty and layers() reports the layers without names. Static groups
+     * are folded even when named. Such models are cached apart from the
+     * full ones.
+     */
+    bool noDynamicProperties{false};
+};
+
 class RLOTTIE_API Animation {
 public:
 
@@ -283,16 +633,35 @@ public:
      *  @return Animation object that can render the contents of the
      *          Lottie resource represented by file path.
      *
+     *  @note the file can also hold the precompiled form, see toBinary().
+     *
      *  @internal
      */
     static std::unique_ptr<Animation>
     loadFromFile(const std::string &path, bool cachePolicy=true);
 
+    /**
+     *  @brief Constructs an animation object from file path.
+     *
+     *  @param[in] path Lottie resource file path
+     *  @param[in] options how to load the resource.
+     *
+     *  @return Animation object that can render the contents of the
+     *          Lottie resource represented by file path.
+     *
+     *  @see LoadOptions
+     *  @internal
+     */
+    static std::unique_ptr<Animation>
+    loadFromFile(const std::string &path, const LoadOptions &options);
+
     /**
      *  @brief Constructs an animation object from JSON string data.
      *
      *  @param[in] jsonData The JSON string data.
      *  @param[in] key the string that will be used to cache the JSON string data.
+     *             when empty the key is derived from a hash of the data, so
+     *             identical data shares one cached model whatever its origin.
      *  @param[in] resourcePath the path will be used to search for external resource.
      *  @param[in] cachePolicy whether to cache or not the model data.
      *             use only when need to explicit disabl caching for a
@@ -302,12 +671,33 @@ public:
      *  @return Animation object that can render the contents of the
      *          Lottie resource represented by JSON string data.
      *
+     *  @note the data can also be the precompiled form, see toBinary().
+     *
      *  @internal
      */
     static std::unique_ptr<Animation>
     loadFromData(std::string jsonData, const std::string &key,
                  const std::string &resourcePath="", bool cachePolicy=true);
 
+    /**
+     *  @brief Constructs an animation object from JSON string data.
+     *
+     *  @param[in] jsonData The JSON string data.
+     *  @param[in] key the string that will be used to cache the JSON string
+     *             data, empty derives it from the data.
+     *  @param[in] resourcePath the path will be used to search for external resource.
+     *  @param[in] options how to load the resource.
+     *
+     *  @return Animation object that can render the contents of the
+     *          Lottie resource represented by JSON string data.
+     *
+     *  @see LoadOptions
+     *  @internal
+     */
+    static std::unique_ptr<Animation>
+    loadFromData(std::string jsonData, const std::string &key,
+                 const std::string &resourcePath, const LoadOptions &options);
+
     /**
      *  @brief Constructs an animation object from JSON string data and update.
      *  the color properties using ColorFilter.
@@ -325,6 +715,171 @@ public:
     static std::unique_ptr<Animation>
     loadFromData(std::string jsonData, std::string resourcePath, ColorFilter filter);
 
+    /**
+     *  @brief Constructs an animation object from JSON string data and update.
+     *  the color properties using ColorFilter, caching the result.
+     *
+     *  The model is cached under a hash of the data combined with
+     *  @p filterKey, so the same data loaded with the same filter is
+     *  parsed only once.
+     *
+     *  @param[in] jsonData The JSON string data.
+     *  @param[in] resourcePath the path will be used to search for external resource.
+     *  @param[in] filter The color filter that will be applied for each color property
+     *             found during parsing.
+     *  @param[in] filterKey the identity of the filter, loads using the same
+     *             key must use filters that produce the same colors. An empty
+     *             key disables the caching.
+     *
+     *  @return Animation object that can render the contents of the
+     *          Lottie resource represented by JSON string data.
+     *
+     *  @internal
+     */
+    static std::unique_ptr<Animation>
+    loadFromData(std::string jsonData, std::string resourcePath,
+                 ColorFilter filter, const std::string &filterKey);
+
+    /**
+     *  @brief Constructs an animation object from data pulled in chunks.
+     *
+     *  The parser keeps only a chunk of the input in memory and consumes
+     *  it as the reader delivers it, so large resources need not be fully
+     *  resident and parsing overlaps the reading.
+     *
+     *  @param[in] reader called with a buffer and its size to fill, returns
+     *             the number of bytes written, 0 at the end of the input.
+     *             It may return less than asked before the end.
+     *  @param[in] key the string that will be used to cache the model, an
+     *             empty key disables the caching as the data is not known
+     *             up front.
+     *  @param[in] resourcePath the path will be used to search for external resource.
+     *  @param[in] cachePolicy whether to cache or not the model data.
+     *
+     *  @return Animation object that can render the contents of the
+     *          Lottie resource, nullptr if the data could not be parsed.
+     *
+     *  @note precompiled and dotLottie data are read in full before decoding.
+     *
+     *  @internal
+     */
+    static std::unique_ptr<Animation>
+    loadFromStream(std::function<size_t(char *buffer, size_t size)> reader,
+                   const std::string &key = {},
+                   const std::string &resourcePath = "", bool cachePolicy = true);
+
+    /**
+     *  @brief Constructs an animation object from an input stream.
+     *
+     *  @param[in] stream the stream to read the Lottie resource from, it is
+     *             read till its end.
+     *  @param[in] key the string that will be used to cache the model, an
+     *             empty key disables the caching.
+     *  @param[in] resourcePath the path will be used to search for external resource.
+     *  @param[in] cachePolicy whether to cache or not the model data.
+     *
+     *  @return Animation object that can render the contents of the
+     *          Lottie resource, nullptr if the data could not be parsed.
+     *
+     *  @see loadFromStream()
+     *  @internal
+     */
+    static std::unique_ptr<Animation>
+    loadFromStream(std::istream &stream, const std::string &key = {},
+                   const std::string &resourcePath = "", bool cachePolicy = true);
+
+    /**
+     *  @brief Loads an animation from file path on a loader thread.
+     *
+     *  @param[in] path Lottie resource file path
+     *  @param[in] cachePolicy whether to cache or not the model data.
+     *
+     *  @return future that holds the Animation object, or nullptr if the
+     *          resource could not be loaded.
+     *
+     *  @note concurrent loads of the same resource with caching enabled
+     *        share a single parse.
+     *
+     *  @see loadFromFile()
+     *  @internal
+     */
+    static std::future<std::unique_ptr<Animation>>
+    loadFromFileAsync(std::string path, bool cachePolicy=true);
+
+    /**
+     *  @brief Loads an animation from file path on a loader thread with the
+     *         given options.
+     *
+     *  @see loadFromFileAsync()
+     *  @see LoadOptions
+     *  @internal
+     */
+    static std::future<std::unique_ptr<Animation>>
+    loadFromFileAsync(std::string path, const LoadOptions &options);
+
+    /**
+     *  @brief Loads an animation from JSON string data on a loader thread.
+     *
+     *  @param[in] jsonData The JSON string data.
+     *  @param[in] key the string that will be used to cache the JSON string data,
+     *             empty derives it from the data, see loadFromData().
+     *  @param[in] resourcePath the path will be used to search for external resource.
+     *  @param[in] cachePolicy whether to cache or not the model data.
+     *
+     *  @return future that holds the Animation object, or nullptr if the
+     *          data could not be parsed.
+     *
+     *  @note concurrent loads of the same key with caching enabled share
+     *        a single parse.
+     *
+     *  @see loadFromData()
+     *  @internal
+     */
+    static std::future<std::unique_ptr<Animation>>
+    loadFromDataAsync(std::string jsonData, std::string key,
+                      std::string resourcePath="", bool cachePolicy=true);
+
+    /**
+     *  @brief Loads an animation from JSON string data on a loader thread
+     *         with the given options.
+     *
+     *  @see loadFromDataAsync()
+     *  @see LoadOptions
+     *  @internal
+     */
+    static std::future<std::unique_ptr<Animation>>
+    loadFromDataAsync(std::string jsonData, std::string key,
+                      std::string resourcePath, const LoadOptions &options);
+
+    /**
+     *  @brief Loads a batch of animations, parsing the files in parallel.
+     *
+     *  @param[in] paths Lottie resource file paths
+     *  @param[in] cachePolicy whether to cache or not the model data.
+     *
+     *  @return one Animation object per path in the same order, nullptr for
+     *          the resources that could not be loaded.
+     *
+     *  @note the calling thread takes part in the loading and returns
+     *        once every file is loaded. Duplicate paths are parsed once
+     *        when caching is enabled.
+     *
+     *  @internal
+     */
+    static std::vector<std::unique_ptr<Animation>>
+    loadFromFiles(const std::vector<std::string> &paths, bool cachePolicy=true);
+
+    /**
+     *  @brief Loads a batch of animations with the given options.
+     *
+     *  @see loadFromFiles()
+     *  @see LoadOptions
+     *  @internal
+     */
+    static std::vector<std::unique_ptr<Animation>>
+    loadFromFiles(const std::vector<std::string> &paths,
+                  const LoadOptions &options);
+
     /**
      *  @brief Returns default framerate of the Lottie resource.
      *
@@ -417,9 +972,228 @@ public:
      *  @param[in] surface Surface in which content will be drawn
      *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
      *
+     *  @return false if the content of @p frameNo is identical to the last
+     *          rendered frame and the content update was skipped.
+     *
+     *  @see isFrameIdentical
+     *  @internal
+     */
+    bool              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio=true);
+
+    /**
+     *  @brief Renders the content to surface Asynchronously and reports the
+     *         area of the surface that changed.
+     *
+     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
+     *  @param[in] surface Surface in which content will be drawn
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *  @param[out] damage bounds of the pixels that differ from the previous
+     *              frame rendered into the same surface. The whole surface
+     *              when the previous frame was rendered in another surface.
+     *              Must stay valid till the future is ready.
+     *
+     *  @return future that will hold the result when rendering finished.
+     *
+     *  @see render
+     *  @internal
+     */
+    std::future<Surface> render(size_t frameNo, Surface surface, bool keepAspectRatio, Rect *damage);
+
+    /**
+     *  @brief Renders the content to surface synchronously and reports the
+     *         area of the surface that changed.
+     *
+     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
+     *  @param[in] surface Surface in which content will be drawn
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *  @param[out] damage bounds of the pixels that differ from the previous
+     *              frame rendered into the same surface. The whole surface
+     *              when the previous frame was rendered in another surface.
+     *
+     *  @return false if the content of @p frameNo is identical to the last
+     *          rendered frame and the content update was skipped.
+     *
+     *  @see renderSync
+     *  @internal
+     */
+    bool              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio, Rect *damage);
+
+    /**
+     *  @brief Renders the content to surface Asynchronously with the given
+     *         priority, the request can be cancelled while it is pending.
+     *
+     *  Use it for frames that may become stale before they are rendered,
+     *  e.g. animations scrolled out of the screen, so that their work is
+     *  dropped instead of delaying the visible frames.
+     *
+     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
+     *  @param[in] surface Surface in which content will be drawn
+     *  @param[in] priority scheduling priority of the request.
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *
+     *  @return handle to wait for or cancel the request.
+     *
+     *  @note like render(), an Animation renders one frame at a time. Wait
+     *        for the previous request before requesting the next frame, a
+     *        cancelled request finishes early.
+     *
+     *  @see render
+     *  @internal
+     */
+    RenderRequest requestRender(size_t frameNo, Surface surface,
+                                RenderPriority priority = RenderPriority::Normal,
+                                bool keepAspectRatio = true);
+
+    /**
+     *  @brief Checks whether two frames have the same content.
+     *
+     *  The frame ranges in which nothing changes in the animation are
+     *  computed when the resource is loaded, so this is a cheap lookup.
+     *  Rendering a frame identical to the last rendered one skips the
+     *  content update.
+     *
+     *  @param[in] prevFrame first frame number
+     *  @param[in] curFrame  second frame number
+     *
+     *  @return true if both frames render the same content.
+     *
+     *  @note Properties changed with setValue() are not taken into account.
+     *
+     *  @internal
+     */
+    bool              isFrameIdentical(size_t prevFrame, size_t curFrame) const;
+
+    /**
+     *  @brief Serializes the loaded resource to the precompiled binary
+     *         format.
+     *
+     *  The binary data holds the parsed model, loading it back with
+     *  loadFromFile() or loadFromData() skips the JSON parsing. Convert
+     *  the resources once at build time and ship the binary form.
+     *
+     *  @return the binary data, empty if the resource can't be serialized.
+     *
+     *  @note The format is versioned and uses the byte order of the
+     *        writer, data of another version or byte order is rejected
+     *        at load time. Embedded images keep their encoded form,
+     *        images read from files are stored decoded. Properties
+     *        changed with setValue() are not part of the data.
+     *
+     *  @internal
+     */
+    std::string       toBinary() const;
+
+    /**
+     *  @brief Writes the precompiled binary form of the resource to a file.
+     *
+     *  @param[in] path destination file path
+     *
+     *  @return true on success.
+     *
+     *  @see toBinary()
+     *  @internal
+     */
+    bool              saveBinary(const std::string &path) const;
+
+    /**
+     *  @brief Returns the memory held by this animation.
+     *
+     *  The model is shared by the animations loaded from the same cached
+     *  resource and is reported in full by each of them.
+     *
+     *  @return the memory used by the model and the renderer.
+     *
+     *  @note a render in progress on another thread is waited for.
+     *
+     *  @see rlottie::memoryStats()
+     *  @internal
+     */
+    MemoryStats       memoryStats() const;
+
+    /**
+     *  @brief Renders a range of frames, overlapping the work of
+     *         consecutive frames.
+     *
+     *  Frame @p startFrame + i is drawn into surfaces[i % surfaces.size()],
+     *  each surface is rendered by its own render context so that the
+     *  update of the next frame runs while the previous one is still
+     *  being rasterized and blended. The call returns once all the frames
+     *  are rendered.
+     *
+     *  @param[in] startFrame first frame of the range.
+     *  @param[in] endFrame last frame of the range (inclusive).
+     *  @param[in] surfaces Surfaces in which the frames will be drawn,
+     *                      pass at least two to overlap the frames.
+     *  @param[in] callback called on the caller thread in frame order with
+     *                      every rendered frame, before its surface is
+     *                      reused for another frame.
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *
+     *  @see renderSync
+     *  @internal
+     */
+    void renderRange(size_t startFrame, size_t endFrame,
+                     const std::vector<Surface> &surfaces,
+                     const std::function<void(size_t frameNo, const Surface &surface)> &callback = nullptr,
+                     bool keepAspectRatio=true);
+
+    /**
+     *  @brief Splits the rendering of a frame in horizontal bands that are
+     *         blended in parallel.
+     *
+     *  Useful for large surfaces, where blending dominates the frame time.
+     *  The number of bands is reduced for small surfaces so that a band
+     *  is never less than 32 lines high.
+     *
+     *  @param[in] bandCount number of bands, 0 or 1 renders the frame on
+     *                       a single thread (default).
+     *
+     *  @note Render contexts created after this call use the same setting.
+     *
+     *  @internal
+     */
+    void setRenderBands(size_t bandCount);
+
+    /**
+     *  @brief Enables partial redraw of the surface.
+     *
+     *  When enabled, rendering a frame into the same surface as the
+     *  previous frame keeps the existing pixels and clears and redraws only
+     *  the rows of the area that changed (see the damage reported by
+     *  renderSync()).
+     *  The content of the surface must not be modified by the caller
+     *  between two frames. A frame rendered into another surface, or with
+     *  another draw region, is always drawn in full.
+     *
+     *  @param[in] enable true to redraw only the damaged area,
+     *                    false to redraw the whole surface (default).
+     *
+     *  @note Render contexts created after this call use the same setting.
+     *
+     *  @internal
+     */
+    void setPartialRedraw(bool enable);
+
+    /**
+     *  @brief Enables the cache of rendered frames.
+     *
+     *  Rendering a frame that is in the cache copies its pixels to the
+     *  surface instead of rendering it again, which makes the following
+     *  iterations of a looping animation cheap. Frames are cached per
+     *  frame number, draw region size and aspect ratio mode, the least
+     *  recently used ones are dropped when the cache grows over
+     *  @p bytes.
+     *
+     *  @param[in] bytes memory budget of the cache in bytes,
+     *                   0 disables the cache (default).
+     *
+     *  @note Frames are not cached once a property is changed with
+     *        setValue().
+     *  @note Render contexts created after this call use the same setting.
+     *
      *  @internal
      */
-    void              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio=true);
+    void setFrameCacheSize(size_t bytes);
 
     /**
      *  @brief Returns root layer of the composition updated with
@@ -435,6 +1209,22 @@ public:
      */
     const LOTLayerNode * renderTree(size_t frameNo, size_t width, size_t height) const;
 
+    /**
+     *  @brief Creates a new render context of this animation.
+     *
+     *  The context has its own render tree and shares the animation data
+     *  with this object, so it can render a frame while this object or
+     *  another context is busy rendering another frame.
+     *  Values set with setValue() before this call are applied to the
+     *  context as well, later changes are not.
+     *
+     *  @return RenderContext that renders the content of this animation.
+     *
+     *  @see RenderContext
+     *  @internal
+     */
+    std::unique_ptr<RenderContext> createRenderContext() const;
+
     /**
      *  @brief Returns Composition Markers.
      *
@@ -46,6 +46,55 @@ typedef enum {
 
 typedef struct Lottie_Animation_S Lottie_Animation;
 
+/**
+ *  @brief Callback invoked by lottie_animation_render_range() for every
+ *         rendered frame.
+ *
+ *  @param[in] data user data passed to lottie_animation_render_range().
+ *  @param[in] frame_num the frame number that was rendered.
+ *  @param[in] buffer the buffer holding the frame content.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+typedef void (*Lottie_Animation_Frame_Cb)(void *data, size_t frame_num, uint32_t *buffer);
+
+/**
+ *  @brief Task handed to a Lottie_Executor, run it with run(task).
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+typedef void (*Lottie_Task_Run)(void *task);
+
+/**
+ *  @brief Executor registered with lottie_configure_executor().
+ *
+ *  Must call run(task) exactly once, on any thread.
+ *
+ *  @param[in] data user data passed to lottie_configure_executor().
+ *  @param[in] run entry point of the task.
+ *  @param[in] task the task to run.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+typedef void (*Lottie_Executor)(void *data, Lottie_Task_Run run, void *task);
+
+/**
+ *  @brief Reader used by lottie_animation_from_reader() to pull the input.
+ *
+ *  @param[in] data user data passed to lottie_animation_from_reader().
+ *  @param[out] buffer the buffer to fill.
+ *  @param[in] size size of the buffer in bytes.
+ *
+ *  @return the number of bytes written, 0 at the end of the input.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+typedef size_t (*Lottie_Read_Cb)(void *data, char *buffer, size_t size);
+
 /**
  *  @brief Runs lottie initialization code when rlottie library is loaded
  * dynamically.
@@ -95,7 +144,8 @@ RLOTTIE_API Lottie_Animation *lottie_animation_from_file(const char *path);
  *  @brief Constructs an animation object from JSON string data.
  *
  *  @param[in] data The JSON string data.
- *  @param[in] key the string that will be used to cache the JSON string data.
+ *  @param[in] key the string that will be used to cache the JSON string data,
+ *                 NULL derives the key from a hash of the data.
  *  @param[in] resource_path the path that will be used to load external resource needed by the JSON data.
  *
  *  @return Animation object that can build the contents of the
@@ -106,6 +156,44 @@ RLOTTIE_API Lottie_Animation *lottie_animation_from_file(const char *path);
  */
 RLOTTIE_API Lottie_Animation *lottie_animation_from_data(const char *data, const char *key, const char *resource_path);
 
+/**
+ *  @brief Constructs an animation object from precompiled binary data.
+ *
+ *  @param[in] data The binary data written by lottie_animation_save_binary().
+ *  @param[in] size Size of the data in bytes.
+ *  @param[in] key the string that will be used to cache the model, NULL
+ *                 disables the caching.
+ *
+ *  @return Animation object that can build the contents of the
+ *          Lottie resource, NULL if the data is not valid.
+ *
+ *  @note lottie_animation_from_file() loads binary files as well.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API Lottie_Animation *lottie_animation_from_binary(const char *data, size_t size, const char *key);
+
+/**
+ *  @brief Constructs an animation object from data pulled in chunks.
+ *
+ *  The input is parsed as it is read, only a chunk of it is kept in
+ *  memory, e.g. a reader calling read() on a file descriptor.
+ *
+ *  @param[in] reader called until it returns 0 to pull the input.
+ *  @param[in] data user data passed to the reader.
+ *  @param[in] key the string that will be used to cache the model, NULL
+ *                 disables the caching.
+ *  @param[in] resource_path the path that will be used to load external resource needed by the data.
+ *
+ *  @return Animation object that can build the contents of the
+ *          Lottie resource, NULL if the data is not valid.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API Lottie_Animation *lottie_animation_from_reader(Lottie_Read_Cb reader, void *data, const char *key, const char *resource_path);
+
 /**
  *  @brief Free given Animation object resource.
  *
@@ -215,6 +303,35 @@ RLOTTIE_API const LOTLayerNode *lottie_animation_render_tree(Lottie_Animation *a
  */
 RLOTTIE_API size_t lottie_animation_get_frame_at_pos(const Lottie_Animation *animation, float pos);
 
+/**
+ *  @brief Checks whether two frames of the animation have the same content.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] prev_frame first frame number.
+ *  @param[in] cur_frame second frame number.
+ *
+ *  @return @c 1 if both frames render the same content, @c 0 otherwise.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API int lottie_animation_is_frame_identical(const Lottie_Animation *animation, size_t prev_frame, size_t cur_frame);
+
+/**
+ *  @brief Writes the precompiled binary form of the animation to a file.
+ *
+ *  Loading the binary file skips the JSON parsing.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] path destination file path.
+ *
+ *  @return @c 1 on success, @c 0 otherwise.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API int lottie_animation_save_binary(const Lottie_Animation *animation, const char *path);
+
 /**
  *  @brief Request to render the content of the frame @p frame_num to buffer @p buffer.
  *
@@ -231,6 +348,44 @@ RLOTTIE_API size_t lottie_animation_get_frame_at_pos(const Lottie_Animation *ani
  */
 RLOTTIE_API void lottie_animation_render(Lottie_Animation *animation, size_t frame_num, uint32_t *buffer, size_t width, size_t height, size_t bytes_per_line);
 
+/**
+ *  @brief Enables the cache of rendered frames of the animation.
+ *
+ *  Rendering a cached frame copies its pixels instead of rendering it again.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] bytes memory budget of the cache in bytes, @c 0 disables it.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_set_frame_cache_size(Lottie_Animation *animation, size_t bytes);
+
+/**
+ *  @brief Request to render the frames [ @p start_frame .. @p end_frame ]
+ *         overlapping the work of consecutive frames.
+ *
+ *  Frame @p start_frame + i is drawn into buffers[i % buffer_count] and
+ *  @p cb is called in frame order once the frame is ready, before the
+ *  buffer is reused. Returns when all the frames are rendered.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] start_frame first frame of the range.
+ *  @param[in] end_frame last frame of the range (inclusive).
+ *  @param[in] buffers surface buffers used for rendering, pass at least
+ *                     two to overlap the frames.
+ *  @param[in] buffer_count number of buffers in @p buffers.
+ *  @param[in] width width of the surfaces
+ *  @param[in] height height of the surfaces
+ *  @param[in] bytes_per_line stride of the surfaces in bytes.
+ *  @param[in] cb callback called with every rendered frame, can be NULL.
+ *  @param[in] data user data passed to @p cb.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_render_range(Lottie_Animation *animation, size_t start_frame, size_t end_frame, uint32_t **buffers, size_t buffer_count, size_t width, size_t height, size_t bytes_per_line, Lottie_Animation_Frame_Cb cb, void *data);
+
 /**
  *  @brief Request to render the content of the frame @p frame_num to buffer @p buffer asynchronously.
  *
@@ -321,6 +476,157 @@ RLOTTIE_API const LOTMarkerList* lottie_animation_get_markerlist(Lottie_Animatio
  */
 RLOTTIE_API void lottie_configure_model_cache_size(size_t cacheSize);
 
+/**
+ *  @brief Configures the memory budget of the model cache.
+ *
+ *  @param[in] bytes  Maximum memory held by the cached models, 0 only
+ *                    limits the number of models.
+ *
+ *  @see lottie_configure_model_cache_size()
+ *  @internal
+ */
+RLOTTIE_API void lottie_configure_model_cache_budget(size_t bytes);
+
+/**
+ *  @brief Counters of the model cache.
+ *
+ *  @internal
+ */
+typedef struct Lottie_Model_Cache_Stats {
+    size_t hits;       /* lookups served from the cache */
+    size_t misses;     /* lookups that had to parse the resource */
+    size_t coalesced;  /* lookups that waited for a parse in progress */
+    size_t evictions;  /* models dropped to honour the limits */
+    size_t entries;    /* models currently cached */
+    size_t bytes;      /* memory held by the cached models */
+} Lottie_Model_Cache_Stats;
+
+/**
+ *  @brief Returns the counters of the model cache.
+ *
+ *  @param[out] stats  the counters.
+ *
+ *  @internal
+ */
+RLOTTIE_API void lottie_model_cache_stats(Lottie_Model_Cache_Stats *stats);
+
+/**
+ *  @brief Memory held by animations, in bytes.
+ *
+ *  @see lottie_animation_get_memory_stats()
+ *  @see lottie_memory_stats()
+ *
+ *  @internal
+ */
+typedef struct Lottie_Memory_Stats {
+    size_t keyframes;    /* keyframes of the animated properties */
+    size_t paths;        /* path points, static and animated */
+    size_t model_arena;  /* arena blocks holding the model objects */
+    size_t images;       /* decoded images */
+    size_t fonts;        /* font entries and glyph outlines */
+    size_t model;        /* whole model, including the fields above */
+    size_t rles;         /* rasterized spans of the shapes, masks, clips */
+    size_t surfaces;     /* offscreen bitmaps kept for reuse */
+    size_t render_tree;  /* nodes of the render tree api */
+    size_t frame_cache;  /* frames kept by the frame cache */
+    size_t renderer;     /* whole renderer, including the fields above */
+    size_t total;        /* model + renderer */
+} Lottie_Memory_Stats;
+
+/**
+ *  @brief Returns the memory held by an animation.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[out] stats  the memory report, its model part is shared with
+ *                     the animations loaded from the same cached resource.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_get_memory_stats(const Lottie_Animation *animation, Lottie_Memory_Stats *stats);
+
+/**
+ *  @brief Returns the memory held by every live animation and the model
+ *  cache, each model counted once.
+ *
+ *  @param[out] stats  the memory report.
+ *
+ *  @internal
+ */
+RLOTTIE_API void lottie_memory_stats(Lottie_Memory_Stats *stats);
+
+/**
+ *  @brief Releases the decoded images of every model, they get decoded
+ *  again the next time they are drawn.
+ *
+ *  @internal
+ */
+RLOTTIE_API void lottie_release_decoded_images(void);
+
+/**
+ *  @brief Configures the worker threads used by asynchronous rendering.
+ *
+ *  @param[in] threadCount  Number of render threads, 0 uses the number of
+ *                          hardware threads.
+ *  @param[in] threadName   Prefix of the thread names, NULL keeps the
+ *                          default "lottie-rnd" prefix.
+ *
+ *  @note must be called before the first lottie_animation_render_async()
+ *        call, once the render threads are running the configuration is
+ *        ignored.
+ *
+ *  @see lottie_animation_render_async()
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_configure_render_threads(size_t threadCount, const char *threadName);
+
+/**
+ *  @brief Configures the worker threads that rasterize and blend a frame.
+ *
+ *  @param[in] threadCount  Number of threads of each pool, 0 uses the
+ *                          number of hardware threads.
+ *
+ *  @note must be called before the first render, once the threads are
+ *        running the configuration is ignored.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_configure_raster_threads(size_t threadCount);
+
+/**
+ *  @brief Pins the worker threads of rlottie to a set of cpus.
+ *
+ *  The n-th thread of each pool runs on cpus[n % count].
+ *
+ *  @param[in] cpus   cpu indices.
+ *  @param[in] count  number of entries in @p cpus, 0 lets the system
+ *                    schedule the threads.
+ *
+ *  @note must be called before the first render. Only supported on linux.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_configure_thread_affinity(const int *cpus, size_t count);
+
+/**
+ *  @brief Runs the tasks of rlottie on the application's executor instead
+ *         of its own threads.
+ *
+ *  @param[in] executor  executor of the tasks, NULL goes back to the
+ *                       rlottie threads.
+ *  @param[in] data      user data passed to @p executor.
+ *
+ *  @see Lottie_Executor
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_configure_executor(Lottie_Executor executor, void *data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -82,7 +82,36 @@ RLOTTIE_API Lottie_Animation_S *lottie_animation_from_file(const char *path)
 
 RLOTTIE_API Lottie_Animation_S *lottie_animation_from_data(const char *data, const char *key, const char *resourcePath)
 {
-    if (auto animation = Animation::loadFromData(data, key, resourcePath) ) {
+    if (!data) return nullptr;
+
+    if (auto animation = Animation::loadFromData(data, key ? key : "", resourcePath ? resourcePath : "") ) {
+        Lottie_Animation_S *handle = new Lottie_Animation_S();
+        handle->mAnimation = std::move(animation);
+        return handle;
+    } else {
+        return nullptr;
+    }
+}
+
+RLOTTIE_API Lottie_Animation_S *lottie_animation_from_binary(const char *data, size_t size, const char *key)
+{
+    if (!data || !size) return nullptr;
+
+    if (auto animation = Animation::loadFromData(std::string(data, size), key ? key : "", "", key != nullptr) ) {
+        Lottie_Animation_S *handle = new Lottie_Animation_S();
+        handle->mAnimation = std::move(animation);
+        return handle;
+    } else {
+        return nullptr;
+    }
+}
+
+RLOTTIE_API Lottie_Animation_S *lottie_animation_from_reader(Lottie_Read_Cb reader, void *data, const char *key, const char *resourcePath)
+{
+    if (!reader) return nullptr;
+
+    auto read = [reader, data](char *buffer, size_t size) { return reader(data, buffer, size); };
+    if (auto animation = Animation::loadFromStream(read, key ? key : "", resourcePath ? resourcePath : "") ) {
         Lottie_Animation_S *handle = new Lottie_Animation_S();
         handle->mAnimation = std::move(animation);
         return handle;
@@ -154,6 +183,24 @@ lottie_animation_get_frame_at_pos(const Lottie_Animation_S *animation, float pos
     return animation->mAnimation->frameAtPos(pos);
 }
 
+RLOTTIE_API int
+lottie_animation_is_frame_identical(const Lottie_Animation_S *animation,
+                                    size_t prev_frame, size_t cur_frame)
+{
+    if (!animation) return 0;
+
+    return animation->mAnimation->isFrameIdentical(prev_frame, cur_frame);
+}
+
+RLOTTIE_API int
+lottie_animation_save_binary(const Lottie_Animation_S *animation,
+                             const char *path)
+{
+    if (!animation || !path) return 0;
+
+    return animation->mAnimation->saveBinary(path);
+}
+
 RLOTTIE_API void
 lottie_animation_render(Lottie_Animation_S *animation,
                         size_t frame_number,
@@ -168,6 +215,41 @@ lottie_animation_render(Lottie_Animation_S *animation,
     animation->mAnimation->renderSync(frame_number, surface);
 }
 
+RLOTTIE_API void
+lottie_animation_set_frame_cache_size(Lottie_Animation_S *animation,
+                                      size_t bytes)
+{
+    if (!animation) return;
+
+    animation->mAnimation->setFrameCacheSize(bytes);
+}
+
+RLOTTIE_API void
+lottie_animation_render_range(Lottie_Animation_S *animation,
+                              size_t start_frame,
+                              size_t end_frame,
+                              uint32_t **buffers,
+                              size_t buffer_count,
+                              size_t width,
+                              size_t height,
+                              size_t bytes_per_line,
+                              Lottie_Animation_Frame_Cb cb,
+                              void *data)
+{
+    if (!animation || !buffers || !buffer_count) return;
+
+    std::vector<rlottie::Surface> surfaces;
+    surfaces.reserve(buffer_count);
+    for (size_t i = 0; i < buffer_count; i++)
+        surfaces.emplace_back(buffers[i], width, height, bytes_per_line);
+
+    animation->mAnimation->renderRange(
+        start_frame, end_frame, surfaces,
+        [cb, data](size_t frame_num, const rlottie::Surface &surface) {
+            if (cb) cb(data, frame_num, surface.buffer());
+        });
+}
+
 RLOTTIE_API void
 lottie_animation_render_async(Lottie_Animation_S *animation,
                               size_t frame_number,
@@ -312,4 +394,103 @@ lottie_configure_model_cache_size(size_t cacheSize)
    rlottie::configureModelCacheSize(cacheSize);
 }
 
+RLOTTIE_API void
+lottie_configure_model_cache_budget(size_t bytes)
+{
+   rlottie::configureModelCacheBudget(bytes);
+}
+
+RLOTTIE_API void
+lottie_model_cache_stats(Lottie_Model_Cache_Stats *stats)
+{
+   if (!stats) return;
+
+   auto result = rlottie::modelCacheStats();
+   stats->hits = result.hits;
+   stats->misses = result.misses;
+   stats->coalesced = result.coalesced;
+   stats->evictions = result.evictions;
+   stats->entries = result.entries;
+   stats->bytes = result.bytes;
+}
+
+static void
+fill_memory_stats(const rlottie::MemoryStats &result, Lottie_Memory_Stats *stats)
+{
+   stats->keyframes = result.keyframes;
+   stats->paths = result.paths;
+   stats->model_arena = result.modelArena;
+   stats->images = result.images;
+   stats->fonts = result.fonts;
+   stats->model = result.model;
+   stats->rles = result.rles;
+   stats->surfaces = result.surfaces;
+   stats->render_tree = result.renderTree;
+   stats->frame_cache = result.frameCache;
+   stats->renderer = result.renderer;
+   stats->total = result.total;
+}
+
+RLOTTIE_API void
+lottie_animation_get_memory_stats(const Lottie_Animation_S *animation,
+                                  Lottie_Memory_Stats *stats)
+{
+   if (!animation || !stats) return;
+
+   fill_memory_stats(animation->mAnimation->memoryStats(), stats);
+}
+
+RLOTTIE_API void
+lottie_memory_stats(Lottie_Memory_Stats *stats)
+{
+   if (!stats) return;
+
+   fill_memory_stats(rlottie::memoryStats(), stats);
+}
+
+RLOTTIE_API void
+lottie_release_decoded_images(void)
+{
+   rlottie::releaseDecodedImages();
+}
+
+RLOTTIE_API void
+lottie_configure_render_threads(size_t threadCount, const char *threadName)
+{
+   rlottie::configureRenderThreads(threadCount, threadName ? threadName : "");
+}
+
+RLOTTIE_API void
+lottie_configure_raster_threads(size_t threadCount)
+{
+   rlottie::configureRasterThreads(threadCount);
+}
+
+RLOTTIE_API void
+lottie_configure_thread_affinity(const int *cpus, size_t count)
+{
+   if (!cpus) count = 0;
+   rlottie::configureThreadAffinity(std::vector<int>(cpus, cpus + count));
+}
+
+static void lottie_executor_task_run(void *task)
+{
+   auto *fn = static_cast<std::function<void()> *>(task);
+   (*fn)();
+   delete fn;
+}
+
+RLOTTIE_API void
+lottie_configure_executor(Lottie_Executor executor, void *data)
+{
+   if (!executor) {
+       rlottie::configureExecutor(nullptr);
+       return;
+   }
+   rlottie::configureExecutor([executor, data](std::function<void()> task) {
+       executor(data, lottie_executor_task_run,
+                new std::function<void()>(std::move(task)));
+   });
+}
+
 }
@@ -23,8 +23,14 @@
 #include "lottieitem.h"
 #include "lottiemodel.h"
 #include "rlottie.h"
+#include "vexecutor.h"
 
+#include <cstring>
 #include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace rlottie;
 using namespace rlottie::internal;
@@ -34,19 +40,136 @@ RLOTTIE_API void rlottie::configureModelCacheSize(size_t cacheSize)
     internal::model::configureModelCacheSize(cacheSize);
 }
 
+RLOTTIE_API void rlottie::configureModelCacheBudget(size_t bytes)
+{
+    internal::model::configureModelCacheBudget(bytes);
+}
+
+RLOTTIE_API ModelCacheStats rlottie::modelCacheStats()
+{
+    auto            stats = internal::model::modelCacheStats();
+    ModelCacheStats result;
+    result.hits = stats.hits;
+    result.misses = stats.misses;
+    result.coalesced = stats.coalesced;
+    result.evictions = stats.evictions;
+    result.entries = stats.entries;
+    result.bytes = stats.bytes;
+    return result;
+}
+
+namespace {
+struct RenderThreadConfig {
+    std::string name{"lottie-rnd"};
+};
+
+RenderThreadConfig &renderThreadConfig()
+{
+    static RenderThreadConfig config;
+    return config;
+}
+
+/*
+ * LRU cache of rendered frames, the pixels of the draw region are kept
+ * as is so that a hit is a plain copy.
+ */
+class FrameCache {
+public:
+    struct Key {
+        size_t frameNo;
+        size_t width;
+        size_t height;
+        bool   keepAspectRatio;
+        bool   operator==(const Key &o) const
+        {
+            return frameNo == o.frameNo && width == o.width &&
+                   height == o.height && keepAspectRatio == o.keepAspectRatio;
+        }
+    };
+
+    size_t limit() const { return mLimit; }
+    size_t size() const { return mSize; }
+    void   setLimit(size_t bytes)
+    {
+        mLimit = bytes;
+        evict(0);
+    }
+    void clear()
+    {
+        mEntries.clear();
+        mIndex.clear();
+        mSize = 0;
+    }
+    const std::vector<uint32_t> *find(const Key &key)
+    {
+        auto search = mIndex.find(key);
+        if (search == mIndex.end()) return nullptr;
+        mEntries.splice(mEntries.begin(), mEntries, search->second);
+        return &search->second->second;
+    }
+    void add(const Key &key, std::vector<uint32_t> &&pixels)
+    {
+        size_t bytes = pixels.size() * sizeof(uint32_t);
+        if (bytes > mLimit || mIndex.count(key)) return;
+        evict(bytes);
+        mEntries.emplace_front(key, std::move(pixels));
+        mIndex[key] = mEntries.begin();
+        mSize += bytes;
+    }
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key &key) const
+        {
+            size_t h = std::hash<size_t>()(key.frameNo);
+            h = h * 31 + std::hash<size_t>()(key.width);
+            h = h * 31 + std::hash<size_t>()(key.height);
+            return h * 31 + key.keepAspectRatio;
+        }
+    };
+    using Entry = std::pair<Key, std::vector<uint32_t>>;
+
+    // drops the least recently used frames till @bytes fits in the limit.
+    void evict(size_t bytes)
+    {
+        while (!mEntries.empty() && mSize + bytes > mLimit) {
+            mSize -= mEntries.back().second.size() * sizeof(uint32_t);
+            mIndex.erase(mEntries.back().first);
+            mEntries.pop_back();
+        }
+    }
+
+    std::list<Entry>                                          mEntries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> mIndex;
+    size_t                                                    mSize{0};
+    size_t                                                    mLimit{0};
+};
+}  // namespace
+
 struct RenderTask {
+    enum State { Queued, Running, Finished };
     RenderTask() { receiver = sender.get_future(); }
+    void                  run();
+    bool                  cancel();
     std::promise<Surface> sender;
     std::future<Surface>  receiver;
     AnimationImpl *       playerImpl{nullptr};
     size_t                frameNo{0};
     Surface               surface;
+    Rect *                damage{nullptr};
     bool                  keepAspectRatio{true};
+    RenderPriority        priority{RenderPriority::Normal};
+    // set only for tasks created by requestRender().
+    std::shared_ptr<std::atomic<bool>> cancelled;
+    std::atomic<int>      state{Queued};
+    std::atomic<bool>     dropped{false};
 };
 using SharedRenderTask = std::shared_ptr<RenderTask>;
 
 class AnimationImpl {
 public:
+    AnimationImpl();
+    ~AnimationImpl();
     void    init(std::shared_ptr<model::Composition> composition);
     bool    update(size_t frameNo, const VSize &size, bool keepAspectRatio);
     VSize   size() const { return mModel->size(); }
@@ -54,11 +177,23 @@ public:
     double  frameRate() const { return mModel->frameRate(); }
     size_t  totalFrame() const { return mModel->totalFrame(); }
     size_t  frameAtPos(double pos) const { return mModel->frameAtPos(pos); }
-    Surface render(size_t frameNo, const Surface &surface,
-                   bool keepAspectRatio);
+    bool    render(size_t frameNo, const Surface &surface,
+                   bool keepAspectRatio, Rect *damage = nullptr,
+                   RenderTask *request = nullptr);
+    bool    isFrameIdentical(size_t prevFrame, size_t curFrame) const;
+    std::string toBinary() const { return model::serialize(*mModel); }
     std::future<Surface> renderAsync(size_t frameNo, Surface &&surface,
-                                     bool keepAspectRatio);
+                                     bool keepAspectRatio,
+                                     Rect *damage = nullptr);
+    SharedRenderTask requestRender(size_t frameNo, Surface &&surface,
+                                   RenderPriority priority,
+                                   bool           keepAspectRatio);
+    void renderRange(size_t startFrame, size_t endFrame,
+                     const std::vector<Surface> &surfaces,
+                     const std::function<void(size_t, const Surface &)> &callback,
+                     bool keepAspectRatio);
     const LOTLayerNode * renderTree(size_t frameNo, const VSize &size);
+    std::unique_ptr<AnimationImpl> createContext() const;
 
     const LayerInfoList &layerInfoList() const
     {
@@ -68,25 +203,189 @@ public:
         return mLayerList;
     }
     const MarkerList &markers() const { return mModel->markers(); }
+    void setRenderBands(size_t count) { mRenderer->setBandCount(count); }
+    void setPartialRedraw(bool enable) { mRenderer->setPartialRedraw(enable); }
+    void setFrameCacheSize(size_t bytes);
     void              setValue(const std::string &keypath, LOTVariant &&value);
     void              removeFilter(const std::string &keypath, Property prop);
+    MemoryStats       memoryStats() const;
+    const model::Composition *model() const { return mModel.get(); }
+    // adds the renderer of this object, without the range contexts.
+    void              rendererMemory(MemoryStats &stats) const;
+    void              releaseImages();
+
+private:
+    bool loadCachedFrame(size_t frameNo, const Surface &surface,
+                         bool keepAspectRatio);
+    void cacheFrame(size_t frameNo, const Surface &surface,
+                    bool keepAspectRatio);
 
 private:
     mutable LayerInfoList                  mLayerList;
-    model::Composition *                   mModel;
+    std::shared_ptr<model::Composition>    mModel;
+    std::vector<std::pair<std::string, LOTVariant>> mDynamicValues;
+    std::vector<std::unique_ptr<AnimationImpl>>     mRangeContexts;
+    FrameCache                             mFrameCache;
     SharedRenderTask                       mTask;
     std::atomic<bool>                      mRenderInProgress;
     std::unique_ptr<renderer::Composition> mRenderer{nullptr};
+    // held while the renderer changes, lets other threads measure it.
+    mutable std::mutex                     mMutex;
+};
+
+namespace {
+/*
+ * Live AnimationImpl objects, lets rlottie::memoryStats() sum the memory
+ * of every renderer in the process.
+ */
+class AnimationRegistry {
+public:
+    static AnimationRegistry &instance()
+    {
+        static AnimationRegistry singleton;
+        return singleton;
+    }
+    void add(AnimationImpl *impl)
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mImpls.insert(impl);
+    }
+    void remove(AnimationImpl *impl)
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mImpls.erase(impl);
+    }
+    template <typename Func>
+    void forEach(Func &&func)
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        for (const auto &e : mImpls) func(e);
+    }
+
+private:
+    std::unordered_set<AnimationImpl *> mImpls;
+    std::mutex                          mMutex;
 };
 
+void addModelMemory(MemoryStats &stats, const model::Composition &model)
+{
+    auto result = model.memoryStats();
+    stats.keyframes += result.keyframes;
+    stats.paths += result.paths;
+    stats.modelArena += result.arena;
+    stats.images += result.images;
+    stats.fonts += result.fonts;
+    stats.model += result.total();
+}
+}  // namespace
+
+AnimationImpl::AnimationImpl()
+{
+    AnimationRegistry::instance().add(this);
+}
+
+AnimationImpl::~AnimationImpl()
+{
+    AnimationRegistry::instance().remove(this);
+}
+
+void AnimationImpl::rendererMemory(MemoryStats &stats) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (!mRenderer) return;
+
+    auto result = mRenderer->memoryStats();
+    stats.rles += result.rles;
+    stats.surfaces += result.surfaces;
+    stats.renderTree += result.renderTree;
+    stats.frameCache += mFrameCache.size();
+    stats.renderer += result.rles + result.surfaces + result.renderTree +
+                      result.arena + mFrameCache.size();
+}
+
+void AnimationImpl::releaseImages()
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (mRenderer) mRenderer->releaseImages();
+}
+
+MemoryStats AnimationImpl::memoryStats() const
+{
+    MemoryStats stats;
+    addModelMemory(stats, *mModel);
+    rendererMemory(stats);
+    for (const auto &e : mRangeContexts) e->rendererMemory(stats);
+    stats.total = stats.model + stats.renderer;
+    return stats;
+}
+
+RLOTTIE_API MemoryStats rlottie::memoryStats()
+{
+    MemoryStats                                    stats;
+    std::unordered_set<const model::Composition *> models;
+
+    for (const auto &e : internal::model::cachedModels()) {
+        if (models.insert(e.get()).second) addModelMemory(stats, *e);
+    }
+    AnimationRegistry::instance().forEach([&](AnimationImpl *impl) {
+        auto comp = impl->model();
+        if (comp && models.insert(comp).second) addModelMemory(stats, *comp);
+        impl->rendererMemory(stats);
+    });
+    stats.total = stats.model + stats.renderer;
+    return stats;
+}
+
+RLOTTIE_API void rlottie::releaseDecodedImages()
+{
+    std::unordered_set<const model::Composition *> models;
+
+    for (const auto &e : internal::model::cachedModels()) {
+        if (models.insert(e.get()).second) e->releaseImages();
+    }
+    AnimationRegistry::instance().forEach([&](AnimationImpl *impl) {
+        impl->releaseImages();
+        auto comp = impl->model();
+        if (comp && models.insert(comp).second) comp->releaseImages();
+    });
+}
+
 void AnimationImpl::setValue(const std::string &keypath, LOTVariant &&value)
 {
     if (keypath.empty()) return;
+    // range contexts have to pick up the new value.
+    mRangeContexts.clear();
+
+    std::lock_guard<std::mutex> guard(mMutex);
     mRenderer->setValue(keypath, value);
+    mFrameCache.clear();
+    // remember the value so that render contexts can replay it.
+    for (auto &e : mDynamicValues) {
+        if (e.first == keypath && e.second.property() == value.property()) {
+            e.second = std::move(value);
+            return;
+        }
+    }
+    mDynamicValues.emplace_back(keypath, std::move(value));
+}
+
+std::unique_ptr<AnimationImpl> AnimationImpl::createContext() const
+{
+    auto context = std::make_unique<AnimationImpl>();
+    context->init(mModel);
+    context->setRenderBands(mRenderer->bandCount());
+    context->setPartialRedraw(mRenderer->partialRedraw());
+    context->setFrameCacheSize(mFrameCache.limit());
+    for (auto &e : mDynamicValues) {
+        auto value = e.second;
+        context->setValue(e.first, std::move(value));
+    }
+    return context;
 }
 
 const LOTLayerNode *AnimationImpl::renderTree(size_t frameNo, const VSize &size)
 {
+    std::lock_guard<std::mutex> guard(mMutex);
     if (update(frameNo, size, true)) {
         mRenderer->buildRenderTree();
     }
@@ -105,30 +404,166 @@ bool AnimationImpl::update(size_t frameNo, const VSize &size,
     return mRenderer->update(int(frameNo), size, keepAspectRatio);
 }
 
-Surface AnimationImpl::render(size_t frameNo, const Surface &surface,
-                              bool keepAspectRatio)
+bool AnimationImpl::render(size_t frameNo, const Surface &surface,
+                           bool keepAspectRatio, Rect *damage,
+                           RenderTask *request)
 {
     bool renderInProgress = mRenderInProgress.load();
     if (renderInProgress) {
         vCritical << "Already Rendering Scheduled for this Animation";
-        return surface;
+        if (damage) *damage = Rect();
+        return false;
     }
 
     mRenderInProgress.store(true);
-    update(
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (loadCachedFrame(frameNo, surface, keepAspectRatio)) {
+        if (damage)
+            *damage = Rect(0, 0, surface.width(), surface.height());
+        mRenderInProgress.store(false);
+        return true;
+    }
+    bool updated = update(
         frameNo,
         VSize(int(surface.drawRegionWidth()), int(surface.drawRegionHeight())),
         keepAspectRatio);
-    mRenderer->render(surface);
+    if (request && request->cancelled) {
+        VRasterRequestScope scope(int(request->priority), request->cancelled);
+        if (!mRenderer->render(surface, request->cancelled.get())) {
+            request->dropped = true;
+            if (damage) *damage = Rect();
+            mRenderInProgress.store(false);
+            return updated;
+        }
+    } else {
+        mRenderer->render(surface);
+    }
+    if (damage) {
+        auto rect = mRenderer->damage();
+        *damage = Rect(size_t(rect.x()), size_t(rect.y()),
+                       size_t(rect.width()), size_t(rect.height()));
+    }
+    cacheFrame(frameNo, surface, keepAspectRatio);
     mRenderInProgress.store(false);
 
-    return surface;
+    return updated;
+}
+
+void RenderTask::run()
+{
+    int expected = Queued;
+    // cancelled while waiting in the queue, the result is already set.
+    if (!state.compare_exchange_strong(expected, Running)) return;
+
+    playerImpl->render(frameNo, surface, keepAspectRatio, damage, this);
+    state.store(Finished);
+    sender.set_value(surface);
+}
+
+bool RenderTask::cancel()
+{
+    cancelled->store(true);
+
+    // claim the task so that the scheduler skips it.
+    int expected = Queued;
+    if (state.compare_exchange_strong(expected, Running)) {
+        dropped = true;
+        state.store(Finished);
+        sender.set_value(surface);
+        return true;
+    }
+    return expected == Running;
+}
+
+void AnimationImpl::setFrameCacheSize(size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mFrameCache.setLimit(bytes);
+    }
+    for (auto &e : mRangeContexts) e->setFrameCacheSize(bytes);
+}
+
+bool AnimationImpl::loadCachedFrame(size_t frameNo, const Surface &surface,
+                                    bool keepAspectRatio)
+{
+    // dynamic properties can change the content of any frame.
+    if (!mFrameCache.limit() || !mDynamicValues.empty() || !totalFrame())
+        return false;
+
+    frameNo = std::min(frameNo, totalFrame() - 1);
+    auto pixels = mFrameCache.find({frameNo, surface.drawRegionWidth(),
+                                    surface.drawRegionHeight(),
+                                    keepAspectRatio});
+    if (!pixels) return false;
+
+    // same result as a render, the surface outside the draw region is
+    // cleared, including the padding of each line.
+    size_t x = surface.drawRegionPosX();
+    size_t y = surface.drawRegionPosY();
+    size_t w = surface.drawRegionWidth();
+    size_t h = surface.drawRegionHeight();
+    size_t stride = surface.bytesPerLine();
+    auto * src = pixels->data();
+    for (size_t i = 0; i < surface.height(); i++) {
+        auto *row = reinterpret_cast<uint8_t *>(surface.buffer()) + i * stride;
+        if (i < y || i >= y + h) {
+            memset(row, 0, stride);
+            continue;
+        }
+        auto left = x * sizeof(uint32_t);
+        auto right = left + w * sizeof(uint32_t);
+        memset(row, 0, left);
+        memcpy(row + left, src, w * sizeof(uint32_t));
+        memset(row + right, 0, stride - right);
+        src += w;
+    }
+
+    // the surface no longer holds the last frame of the render tree.
+    mRenderer->invalidateDamage();
+    return true;
+}
+
+void AnimationImpl::cacheFrame(size_t frameNo, const Surface &surface,
+                               bool keepAspectRatio)
+{
+    if (!mFrameCache.limit() || !mDynamicValues.empty() || !totalFrame())
+        return;
+
+    size_t x = surface.drawRegionPosX();
+    size_t y = surface.drawRegionPosY();
+    size_t w = surface.drawRegionWidth();
+    size_t h = surface.drawRegionHeight();
+    if (w * h * sizeof(uint32_t) > mFrameCache.limit()) return;
+
+    frameNo = std::min(frameNo, totalFrame() - 1);
+
+    std::vector<uint32_t> pixels(w * h);
+    auto *                dst = pixels.data();
+    for (size_t i = y; i < y + h; i++) {
+        auto *row = reinterpret_cast<uint32_t *>(
+            reinterpret_cast<uint8_t *>(surface.buffer()) +
+            i * surface.bytesPerLine());
+        memcpy(dst, row + x, w * sizeof(uint32_t));
+        dst += w;
+    }
+    mFrameCache.add({frameNo, w, h, keepAspectRatio}, std::move(pixels));
+}
+
+bool AnimationImpl::isFrameIdentical(size_t prevFrame, size_t curFrame) const
+{
+    auto clamp = [this](size_t frameNo) {
+        frameNo += mModel->startFrame();
+        if (frameNo > mModel->endFrame()) frameNo = mModel->endFrame();
+        return int(frameNo);
+    };
+    return mModel->isFrameIdentical(clamp(prevFrame), clamp(curFrame));
 }
 
 void AnimationImpl::init(std::shared_ptr<model::Composition> composition)
 {
-    mModel = composition.get();
-    mRenderer = std::make_unique<renderer::Composition>(composition);
+    mModel = composition;
+    mRenderer = std::make_unique<renderer::Composition>(std::move(composition));
     mRenderInProgress = false;
 }
 
@@ -137,6 +572,11 @@ void AnimationImpl::init(std::shared_ptr<model::Composition> composition)
 #include <thread>
 #include "vtaskqueue.h"
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sstream>
+#endif
+
 /*
  * Implement a task stealing schduler to perform render task
  * As each player draws into its own buffer we can delegate this
@@ -149,16 +589,36 @@ void AnimationImpl::init(std::shared_ptr<model::Composition> composition)
  * just waits for new task on its own queue.
  */
 class RenderTaskScheduler {
-    const unsigned           _count{std::thread::hardware_concurrency()};
+    struct Priority {
+        int operator()(const SharedRenderTask &task) const
+        {
+            return int(task->priority);
+        }
+    };
+
+    const unsigned _count{VExecutor::threadCount(VExecutor::Pool::Render)};
     std::vector<std::thread> _threads;
-    std::vector<TaskQueue<SharedRenderTask>> _q{_count};
-    std::atomic<unsigned>                    _index{0};
+    std::vector<TaskQueue<SharedRenderTask, Priority>> _q{_count};
+    std::atomic<unsigned>                              _index{0};
+
+    static void execute(const SharedRenderTask &task) { task->run(); }
 
     void run(unsigned i)
     {
+        // Create Thread Name for Debugging (Linux)
+#ifdef __linux__
+        std::ostringstream nameStream;
+        nameStream << renderThreadConfig().name << "-" << i;
+        // thread names are limited to 16 bytes including the terminator.
+        auto name = nameStream.str().substr(0, 15);
+        pthread_setname_np(pthread_self(), name.c_str());
+#endif
+        VExecutor::applyAffinity(i);
+
         while (true) {
             bool             success = false;
             SharedRenderTask task;
+            // try our own queue first, then steal from the others.
             for (unsigned n = 0; n != _count * 2; ++n) {
                 if (_q[(i + n) % _count].try_pop(task)) {
                     success = true;
@@ -167,9 +627,7 @@ class RenderTaskScheduler {
             }
             if (!success && !_q[i].pop(task)) break;
 
-            auto result = task->playerImpl->render(task->frameNo, task->surface,
-                                                   task->keepAspectRatio);
-            task->sender.set_value(result);
+            execute(task);
         }
     }
 
@@ -206,18 +664,33 @@ public:
     std::future<Surface> process(SharedRenderTask task)
     {
         auto receiver = std::move(task->receiver);
+
+        // no worker available, render on the caller thread.
+        if (!_count || !IsRunning) {
+            execute(task);
+            return receiver;
+        }
+
         auto i = _index++;
 
         for (unsigned n = 0; n != _count; ++n) {
             if (_q[(i + n) % _count].try_push(std::move(task))) return receiver;
         }
 
-        if (_count > 0) {
-            _q[i % _count].push(std::move(task));
-        }
+        _q[i % _count].push(std::move(task));
 
         return receiver;
     }
+
+    // queues the task on the application executor when one is set.
+    static std::future<Surface> schedule(SharedRenderTask task)
+    {
+        if (!VExecutor::external()) return instance().process(std::move(task));
+
+        auto receiver = std::move(task->receiver);
+        VExecutor::submit([task] { task->run(); });
+        return receiver;
+    }
 };
 
 #else
@@ -235,33 +708,242 @@ public:
 
     std::future<Surface> process(SharedRenderTask task)
     {
-        auto result = task->playerImpl->render(task->frameNo, task->surface,
-                                               task->keepAspectRatio);
-        task->sender.set_value(result);
+        task->run();
         return std::move(task->receiver);
     }
+
+    static std::future<Surface> schedule(SharedRenderTask task)
+    {
+        return instance().process(std::move(task));
+    }
 };
 
 #endif
 
 bool RenderTaskScheduler::IsRunning{false};
 
+#ifdef LOTTIE_THREAD_SUPPORT
+
+using LoadTask = std::function<void()>;
+
+/*
+ * Parses resources off the caller thread. Loads are kept away from the
+ * render threads so that a big file does not stall the queued frames.
+ */
+class LoadTaskScheduler {
+    const unsigned _count{VExecutor::threadCount(VExecutor::Pool::Load)};
+    std::vector<std::thread>         _threads;
+    std::vector<TaskQueue<LoadTask>> _q{_count};
+    std::atomic<unsigned>            _index{0};
+
+    void run(unsigned i)
+    {
+        // Create Thread Name for Debugging (Linux)
+#ifdef __linux__
+        std::ostringstream nameStream;
+        nameStream << "lottie-ld-" << i;
+        pthread_setname_np(pthread_self(), nameStream.str().c_str());
+#endif
+        VExecutor::applyAffinity(i);
+
+        while (true) {
+            bool     success = false;
+            LoadTask task;
+            for (unsigned n = 0; n != _count * 2; ++n) {
+                if (_q[(i + n) % _count].try_pop(task)) {
+                    success = true;
+                    break;
+                }
+            }
+            if (!success && !_q[i].pop(task)) break;
+
+            task();
+        }
+    }
+
+    LoadTaskScheduler()
+    {
+        for (unsigned n = 0; n != _count; ++n) {
+            _threads.emplace_back([&, n] { run(n); });
+        }
+
+        IsRunning = true;
+    }
+
+    void process(LoadTask task)
+    {
+        if (!_count || !IsRunning) {
+            task();
+            return;
+        }
+
+        auto i = _index++;
+
+        for (unsigned n = 0; n != _count; ++n) {
+            if (_q[(i + n) % _count].try_push(std::move(task))) return;
+        }
+
+        _q[i % _count].push(std::move(task));
+    }
+
+public:
+    static bool IsRunning;
+
+    static LoadTaskScheduler &instance()
+    {
+        static LoadTaskScheduler singleton;
+        return singleton;
+    }
+
+    ~LoadTaskScheduler() { stop(); }
+
+    void stop()
+    {
+        if (IsRunning) {
+            IsRunning = false;
+
+            for (auto &e : _q) e.done();
+            for (auto &e : _threads) e.join();
+        }
+    }
+
+    static void schedule(LoadTask task)
+    {
+        if (VExecutor::external())
+            VExecutor::submit(std::move(task));
+        else
+            instance().process(std::move(task));
+    }
+
+    static void parallelFor(size_t begin, size_t end,
+                            const std::function<void(size_t)> &fn)
+    {
+        VExecutor::parallelFor(begin, end, fn, schedule);
+    }
+};
+
+#else
+
+using LoadTask = std::function<void()>;
+
+class LoadTaskScheduler {
+public:
+    static bool IsRunning;
+
+    static LoadTaskScheduler &instance()
+    {
+        static LoadTaskScheduler singleton;
+        return singleton;
+    }
+
+    void stop() {}
+
+    static void schedule(LoadTask task) { task(); }
+
+    static void parallelFor(size_t begin, size_t end,
+                            const std::function<void(size_t)> &fn)
+    {
+        for (size_t i = begin; i < end; i++) fn(i);
+    }
+};
+
+#endif
+
+bool LoadTaskScheduler::IsRunning{false};
+
+RLOTTIE_API void rlottie::configureRenderThreads(size_t             threadCount,
+                                                 const std::string &threadName)
+{
+    if (RenderTaskScheduler::IsRunning) {
+        vWarning << "Render threads are already running, configure them "
+                    "before the first render";
+        return;
+    }
+    VExecutor::setThreadCount(VExecutor::Pool::Render, threadCount);
+    if (!threadName.empty()) renderThreadConfig().name = threadName;
+}
+
+RLOTTIE_API void rlottie::configureRasterThreads(size_t threadCount)
+{
+    VExecutor::setThreadCount(VExecutor::Pool::Raster, threadCount);
+    VExecutor::setThreadCount(VExecutor::Pool::Band, threadCount);
+}
+
+RLOTTIE_API void rlottie::configureThreadAffinity(std::vector<int> cpus)
+{
+    VExecutor::setAffinity(std::move(cpus));
+}
+
+RLOTTIE_API void rlottie::configureExecutor(Executor executor)
+{
+    VExecutor::setCallback(std::move(executor));
+}
+
 std::future<Surface> AnimationImpl::renderAsync(size_t    frameNo,
                                                 Surface &&surface,
-                                                bool      keepAspectRatio)
+                                                bool      keepAspectRatio,
+                                                Rect *    damage)
 {
     if (!mTask) {
         mTask = std::make_shared<RenderTask>();
     } else {
         mTask->sender = std::promise<Surface>();
         mTask->receiver = mTask->sender.get_future();
+        mTask->state = RenderTask::Queued;
     }
     mTask->playerImpl = this;
     mTask->frameNo = frameNo;
     mTask->surface = std::move(surface);
+    mTask->damage = damage;
     mTask->keepAspectRatio = keepAspectRatio;
 
-    return RenderTaskScheduler::instance().process(mTask);
+    return RenderTaskScheduler::schedule(mTask);
+}
+
+SharedRenderTask AnimationImpl::requestRender(size_t         frameNo,
+                                              Surface &&     surface,
+                                              RenderPriority priority,
+                                              bool           keepAspectRatio)
+{
+    // a request can be cancelled while queued, it needs its own task.
+    auto task = std::make_shared<RenderTask>();
+    task->playerImpl = this;
+    task->frameNo = frameNo;
+    task->surface = std::move(surface);
+    task->keepAspectRatio = keepAspectRatio;
+    task->priority = priority;
+    task->cancelled = std::make_shared<std::atomic<bool>>(false);
+
+    return task;
+}
+
+void AnimationImpl::renderRange(
+    size_t startFrame, size_t endFrame, const std::vector<Surface> &surfaces,
+    const std::function<void(size_t, const Surface &)> &callback,
+    bool keepAspectRatio)
+{
+    if (surfaces.empty() || startFrame > endFrame) return;
+
+    // one render context per surface, the first one is this object.
+    size_t depth = std::min(surfaces.size(), endFrame - startFrame + 1);
+    while (mRangeContexts.size() + 1 < depth) {
+        mRangeContexts.push_back(createContext());
+    }
+
+    std::vector<std::future<Surface>> pending(depth);
+    size_t next = startFrame;
+    for (size_t frameNo = startFrame; frameNo <= endFrame; frameNo++) {
+        // keep every context busy while waiting for the oldest frame.
+        for (; next <= endFrame && next - frameNo < depth; next++) {
+            auto  slot = (next - startFrame) % depth;
+            auto *impl = slot ? mRangeContexts[slot - 1].get() : this;
+            pending[slot] = impl->renderAsync(
+                next, Surface(surfaces[slot]), keepAspectRatio);
+        }
+
+        auto surface = pending[(frameNo - startFrame) % depth].get();
+        if (callback) callback(frameNo, surface);
+    }
 }
 
 /**
@@ -272,14 +954,24 @@ std::future<Surface> AnimationImpl::renderAsync(size_t    frameNo,
 std::unique_ptr<Animation> Animation::loadFromData(
     std::string jsonData, const std::string &key,
     const std::string &resourcePath, bool cachePolicy)
+{
+    LoadOptions options;
+    options.cachePolicy = cachePolicy;
+    return loadFromData(std::move(jsonData), key, resourcePath, options);
+}
+
+std::unique_ptr<Animation> Animation::loadFromData(
+    std::string jsonData, const std::string &key,
+    const std::string &resourcePath, const LoadOptions &options)
 {
     if (jsonData.empty()) {
         vWarning << "jason data is empty";
         return nullptr;
     }
 
-    auto composition = model::loadFromData(std::move(jsonData), key,
-                                           resourcePath, cachePolicy);
+    auto composition =
+        model::loadFromData(std::move(jsonData), key, resourcePath,
+                            options.cachePolicy, options.noDynamicProperties);
     if (composition) {
         auto animation = std::unique_ptr<Animation>(new Animation);
         animation->d->init(std::move(composition));
@@ -292,14 +984,24 @@ std::unique_ptr<Animation> Animation::loadFromData(
 std::unique_ptr<Animation> Animation::loadFromData(std::string jsonData,
                                                    std::string resourcePath,
                                                    ColorFilter filter)
+{
+    return loadFromData(std::move(jsonData), std::move(resourcePath),
+                        std::move(filter), {});
+}
+
+std::unique_ptr<Animation> Animation::loadFromData(std::string jsonData,
+                                                   std::string resourcePath,
+                                                   ColorFilter filter,
+                                                   const std::string &filterKey)
 {
     if (jsonData.empty()) {
         vWarning << "jason data is empty";
         return nullptr;
     }
 
-    auto composition = model::loadFromData(
-        std::move(jsonData), std::move(resourcePath), std::move(filter));
+    auto composition =
+        model::loadFromData(std::move(jsonData), std::move(resourcePath),
+                            std::move(filter), filterKey);
     if (composition) {
         auto animation = std::unique_ptr<Animation>(new Animation);
         animation->d->init(std::move(composition));
@@ -308,15 +1010,55 @@ std::unique_ptr<Animation> Animation::loadFromData(std::string jsonData,
     return nullptr;
 }
 
+std::unique_ptr<Animation> Animation::loadFromStream(
+    std::function<size_t(char *buffer, size_t size)> reader,
+    const std::string &key, const std::string &resourcePath, bool cachePolicy)
+{
+    if (!reader) {
+        vWarning << "stream reader is empty";
+        return nullptr;
+    }
+
+    auto composition = model::loadFromStream(std::move(reader), key,
+                                             resourcePath, cachePolicy);
+    if (composition) {
+        auto animation = std::unique_ptr<Animation>(new Animation);
+        animation->d->init(std::move(composition));
+        return animation;
+    }
+    return nullptr;
+}
+
+std::unique_ptr<Animation> Animation::loadFromStream(
+    std::istream &stream, const std::string &key,
+    const std::string &resourcePath, bool cachePolicy)
+{
+    return loadFromStream(
+        [&stream](char *buffer, size_t size) {
+            stream.read(buffer, std::streamsize(size));
+            return size_t(stream.gcount());
+        },
+        key, resourcePath, cachePolicy);
+}
+
 std::unique_ptr<Animation> Animation::loadFromFile(const std::string &path,
                                                    bool cachePolicy)
+{
+    LoadOptions options;
+    options.cachePolicy = cachePolicy;
+    return loadFromFile(path, options);
+}
+
+std::unique_ptr<Animation> Animation::loadFromFile(const std::string &path,
+                                                   const LoadOptions &options)
 {
     if (path.empty()) {
         vWarning << "File path is empty";
         return nullptr;
     }
 
-    auto composition = model::loadFromFile(path, cachePolicy);
+    auto composition = model::loadFromFile(path, options.cachePolicy,
+                                           options.noDynamicProperties);
     if (composition) {
         auto animation = std::unique_ptr<Animation>(new Animation);
         animation->d->init(std::move(composition));
@@ -325,6 +1067,107 @@ std::unique_ptr<Animation> Animation::loadFromFile(const std::string &path,
     return nullptr;
 }
 
+std::future<std::unique_ptr<Animation>>
+Animation::loadFromFileAsync(std::string path, bool cachePolicy)
+{
+    LoadOptions options;
+    options.cachePolicy = cachePolicy;
+    return loadFromFileAsync(std::move(path), options);
+}
+
+std::future<std::unique_ptr<Animation>>
+Animation::loadFromFileAsync(std::string path, const LoadOptions &options)
+{
+    using Result = std::promise<std::unique_ptr<Animation>>;
+
+    auto sender = std::make_shared<Result>();
+    auto receiver = sender->get_future();
+    LoadTaskScheduler::schedule([sender, path, options] {
+        sender->set_value(loadFromFile(path, options));
+    });
+    return receiver;
+}
+
+std::future<std::unique_ptr<Animation>>
+Animation::loadFromDataAsync(std::string jsonData, std::string key,
+                             std::string resourcePath, bool cachePolicy)
+{
+    LoadOptions options;
+    options.cachePolicy = cachePolicy;
+    return loadFromDataAsync(std::move(jsonData), std::move(key),
+                             std::move(resourcePath), options);
+}
+
+std::future<std::unique_ptr<Animation>>
+Animation::loadFromDataAsync(std::string jsonData, std::string key,
+                             std::string resourcePath, const LoadOptions &options)
+{
+    struct Request {
+        std::promise<std::unique_ptr<Animation>> sender;
+        std::string                              jsonData;
+        std::string                              key;
+        std::string                              resourcePath;
+    };
+
+    auto request = std::make_shared<Request>();
+    request->jsonData = std::move(jsonData);
+    request->key = std::move(key);
+    request->resourcePath = std::move(resourcePath);
+
+    auto receiver = request->sender.get_future();
+    LoadTaskScheduler::schedule([request, options] {
+        request->sender.set_value(
+            loadFromData(std::move(request->jsonData), request->key,
+                         request->resourcePath, options));
+    });
+    return receiver;
+}
+
+std::vector<std::unique_ptr<Animation>>
+Animation::loadFromFiles(const std::vector<std::string> &paths,
+                         bool                            cachePolicy)
+{
+    LoadOptions options;
+    options.cachePolicy = cachePolicy;
+    return loadFromFiles(paths, options);
+}
+
+std::vector<std::unique_ptr<Animation>>
+Animation::loadFromFiles(const std::vector<std::string> &paths,
+                         const LoadOptions &             options)
+{
+    std::vector<std::unique_ptr<Animation>> result(paths.size());
+
+    LoadTaskScheduler::parallelFor(0, paths.size(), [&](size_t i) {
+        result[i] = loadFromFile(paths[i], options);
+    });
+    return result;
+}
+
+std::string Animation::toBinary() const
+{
+    return d->toBinary();
+}
+
+MemoryStats Animation::memoryStats() const
+{
+    return d->memoryStats();
+}
+
+bool Animation::saveBinary(const std::string &path) const
+{
+    auto data = toBinary();
+    if (data.empty()) return false;
+
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f.is_open()) {
+        vCritical << "failed to open file = " << path.c_str();
+        return false;
+    }
+    f.write(data.data(), std::streamsize(data.size()));
+    return bool(f);
+}
+
 void Animation::size(size_t &width, size_t &height) const
 {
     VSize sz = d->size();
@@ -365,10 +1208,101 @@ std::future<Surface> Animation::render(size_t frameNo, Surface surface,
     return d->renderAsync(frameNo, std::move(surface), keepAspectRatio);
 }
 
-void Animation::renderSync(size_t frameNo, Surface surface,
+bool Animation::renderSync(size_t frameNo, Surface surface,
                            bool keepAspectRatio)
 {
-    d->render(frameNo, surface, keepAspectRatio);
+    return d->render(frameNo, surface, keepAspectRatio);
+}
+
+std::future<Surface> Animation::render(size_t frameNo, Surface surface,
+                                       bool keepAspectRatio, Rect *damage)
+{
+    return d->renderAsync(frameNo, std::move(surface), keepAspectRatio,
+                          damage);
+}
+
+bool Animation::renderSync(size_t frameNo, Surface surface,
+                           bool keepAspectRatio, Rect *damage)
+{
+    return d->render(frameNo, surface, keepAspectRatio, damage);
+}
+
+RenderRequest Animation::requestRender(size_t frameNo, Surface surface,
+                                       RenderPriority priority,
+                                       bool           keepAspectRatio)
+{
+    auto task = d->requestRender(frameNo, std::move(surface), priority,
+                                 keepAspectRatio);
+    auto result = RenderTaskScheduler::schedule(task).share();
+    return RenderRequest(std::move(task), std::move(result));
+}
+
+RenderRequest::RenderRequest(std::shared_ptr<RenderTask> task,
+                             std::shared_future<Surface> result)
+    : d(std::move(task)), mResult(std::move(result))
+{
+}
+
+bool RenderRequest::valid() const
+{
+    return d != nullptr;
+}
+
+bool RenderRequest::cancel()
+{
+    if (!d) return false;
+    return d->cancel();
+}
+
+bool RenderRequest::cancelled() const
+{
+    if (!d || d->state.load() != RenderTask::Finished) return false;
+    return d->dropped;
+}
+
+RenderPriority RenderRequest::priority() const
+{
+    if (!d) return RenderPriority::Normal;
+    return d->priority;
+}
+
+Surface RenderRequest::get() const
+{
+    if (!d) return Surface();
+    return mResult.get();
+}
+
+bool Animation::isFrameIdentical(size_t prevFrame, size_t curFrame) const
+{
+    return d->isFrameIdentical(prevFrame, curFrame);
+}
+
+void Animation::renderRange(
+    size_t startFrame, size_t endFrame, const std::vector<Surface> &surfaces,
+    const std::function<void(size_t, const Surface &)> &callback,
+    bool keepAspectRatio)
+{
+    d->renderRange(startFrame, endFrame, surfaces, callback, keepAspectRatio);
+}
+
+void Animation::setRenderBands(size_t bandCount)
+{
+    d->setRenderBands(bandCount);
+}
+
+void Animation::setPartialRedraw(bool enable)
+{
+    d->setPartialRedraw(enable);
+}
+
+void Animation::setFrameCacheSize(size_t bytes)
+{
+    d->setFrameCacheSize(bytes);
+}
+
+std::unique_ptr<RenderContext> Animation::createRenderContext() const
+{
+    return std::unique_ptr<RenderContext>(new RenderContext(d->createContext()));
 }
 
 const LayerInfoList &Animation::layers() const
@@ -436,6 +1370,24 @@ void Animation::setValue(Point_Type, Property prop, const std::string &keypath,
 Animation::~Animation() = default;
 Animation::Animation() : d(std::make_unique<AnimationImpl>()) {}
 
+std::future<Surface> RenderContext::render(size_t frameNo, Surface surface,
+                                           bool keepAspectRatio)
+{
+    return d->renderAsync(frameNo, std::move(surface), keepAspectRatio);
+}
+
+bool RenderContext::renderSync(size_t frameNo, Surface surface,
+                               bool keepAspectRatio)
+{
+    return d->render(frameNo, surface, keepAspectRatio);
+}
+
+RenderContext::~RenderContext() = default;
+RenderContext::RenderContext(std::unique_ptr<AnimationImpl> impl)
+    : d(std::move(impl))
+{
+}
+
 Surface::Surface(uint32_t *buffer, size_t width, size_t height,
                  size_t bytesPerLine)
     : mBuffer(buffer),
@@ -464,6 +1416,13 @@ void lottieShutdownRenderTaskScheduler()
         RenderTaskScheduler::instance().stop();
     }
 }
+
+void lottieShutdownLoadTaskScheduler()
+{
+    if (LoadTaskScheduler::IsRunning) {
+        LoadTaskScheduler::instance().stop();
+    }
+}
 }  // namespace
 
 // private apis exposed to c interface
@@ -473,10 +1432,13 @@ void lottie_init_impl()
 }
 
 extern void lottieShutdownRasterTaskScheduler();
+extern void lottieShutdownBandTaskScheduler();
 
 void lottie_shutdown_impl()
 {
+    lottieShutdownLoadTaskScheduler();
     lottieShutdownRenderTaskScheduler();
+    lottieShutdownBandTaskScheduler();
     lottieShutdownRasterTaskScheduler();
 }
 
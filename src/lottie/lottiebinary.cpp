@@ -0,0 +1,1366 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstring>
+#include "lottiemodel.h"
+
+using namespace rlottie::internal;
+
+/*
+ * Precompiled model format.
+ *
+ * A fixed header (magic, format version, byte order mark) is followed by
+ * the composition written depth first. Values are fixed size, unaligned
+ * and in the byte order of the writer, a reader with another byte order
+ * rejects the data.
+ * Objects and interpolators are written once, the first use defines them
+ * and every later use refers to the definition by its index. The data
+ * holds no pointers, loading rebuilds the objects in the model arena and
+ * resolves the indices and the asset references.
+ * The model is stored after the parser post processing (repeater
+ * grouping, static content folding, cached position tangents, identical
+ * frame ranges), so none of it runs again at load time.
+ * Bump BinaryVersion whenever the layout changes, older data is then
+ * rejected instead of misread.
+ */
+
+namespace {
+
+constexpr char     BinaryMagic[4] = {'\x89', 'R', 'L', 'M'};
+constexpr uint16_t BinaryVersion = 3;
+constexpr uint16_t BinaryByteOrder = 0x0102;
+constexpr size_t   BinaryHeaderSize = 8;
+constexpr int      MaxObjectDepth = 1024;
+
+// how the image of an asset is stored.
+enum class ImageStorage : uint8_t { None, Decoded, Encoded };
+
+class BinaryWriter {
+public:
+    std::string result() { return std::move(mOut); }
+
+    template <typename T>
+    void pod(const T &value)
+    {
+        mOut.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    void count(size_t n) { pod(uint32_t(n)); }
+
+    void write(bool value) { pod(uint8_t(value)); }
+    void write(int value) { pod(int32_t(value)); }
+    void write(float value) { pod(value); }
+    void write(double value) { pod(value); }
+    void write(const std::string &str)
+    {
+        count(str.size());
+        mOut.append(str);
+    }
+    void write(const VPointF &pt)
+    {
+        write(pt.x());
+        write(pt.y());
+    }
+    void write(const model::Color &color)
+    {
+        write(color.r);
+        write(color.g);
+        write(color.b);
+    }
+    void write(const model::PathData &path)
+    {
+        count(path.mPoints.size());
+        for (const auto &e : path.mPoints) write(e);
+        write(path.mClosed);
+    }
+    void write(const model::Gradient::Data &gradient)
+    {
+        count(gradient.mGradient.size());
+        for (const auto &e : gradient.mGradient) write(e);
+    }
+    void write(const VPath &path)
+    {
+        count(path.elements().size());
+        for (const auto &e : path.elements()) pod(uint8_t(e));
+        count(path.points().size());
+        for (const auto &e : path.points()) write(e);
+    }
+    void write(const VMatrix &m)
+    {
+        write(m.m_11());
+        write(m.m_12());
+        write(m.m_13());
+        write(m.m_21());
+        write(m.m_22());
+        write(m.m_23());
+        write(m.m_tx());
+        write(m.m_ty());
+        write(m.m_33());
+    }
+
+    template <typename T>
+    void write(const model::Value<T> &value)
+    {
+        write(value.start_);
+        write(value.end_);
+    }
+    template <typename T>
+    void write(const model::Value<T, model::Position> &value)
+    {
+        write(value.start_);
+        write(value.end_);
+        write(value.inTangent_);
+        write(value.outTangent_);
+        write(value.length_);
+        write(value.hasTangent_);
+    }
+    template <typename T, typename Tag>
+    void write(const model::Property<T, Tag> &prop)
+    {
+        write(prop.isStatic());
+        if (prop.isStatic()) {
+            write(prop.value());
+            return;
+        }
+        const auto &animation = prop.animation();
+        count(animation.frames_.size());
+        for (size_t i = 0; i < animation.frames_.size(); i++) {
+            const auto &e = animation.frames_[i];
+            write(e.start_);
+            write(e.end_);
+            write(e.interpolator_);
+            write(animation.values_[i]);
+        }
+    }
+    void write(const model::Dash &dash)
+    {
+        count(dash.mData.size());
+        for (const auto &e : dash.mData) write(e);
+    }
+
+    void write(const VInterpolator *interpolator)
+    {
+        if (!interpolator) return pod(uint32_t(0));
+
+        auto search = mInterpolators.find(interpolator);
+        if (search != mInterpolators.end()) return pod(search->second);
+
+        auto id = uint32_t(mInterpolators.size() + 1);
+        mInterpolators[interpolator] = id;
+        pod(id);
+        write(interpolator->p1());
+        write(interpolator->p2());
+    }
+
+    void write(const model::Object *obj);
+    void write(const model::Composition &comp);
+
+private:
+    void writeGroup(const model::Group *obj);
+    void writeLayer(const model::Layer *obj);
+    void writeTransform(const model::Transform *obj);
+    void writeGradient(const model::Gradient *obj);
+    void writeText(const model::TextLayerData &text);
+    void writeAsset(const model::Asset *asset);
+
+    std::string                                               mOut;
+    std::unordered_map<const model::Object *, uint32_t>       mObjects;
+    std::unordered_map<const VInterpolator *, uint32_t>       mInterpolators;
+};
+
+void BinaryWriter::writeGroup(const model::Group *obj)
+{
+    count(obj->mChildren.size());
+    for (const auto &e : obj->mChildren) write(e);
+    write(obj->mTransform);
+}
+
+void BinaryWriter::writeTransform(const model::Transform *obj)
+{
+    auto data = obj->data();
+    if (!data) {
+        write(obj->matrix(0));
+        write(obj->opacity(0));
+        return;
+    }
+    write(data->mRotation);
+    write(data->mScale);
+    write(data->mPosition);
+    write(data->mAnchor);
+    write(data->mOpacity);
+    write(bool(data->mExtra));
+    if (data->mExtra) {
+        auto extra = data->mExtra.get();
+        write(extra->m3DRx);
+        write(extra->m3DRy);
+        write(extra->m3DRz);
+        write(extra->mSeparateX);
+        write(extra->mSeparateY);
+        write(extra->mSeparate);
+        write(extra->m3DData);
+    }
+}
+
+void BinaryWriter::writeGradient(const model::Gradient *obj)
+{
+    write(obj->mGradientType);
+    write(obj->mStartPoint);
+    write(obj->mEndPoint);
+    write(obj->mHighlightLength);
+    write(obj->mHighlightAngle);
+    write(obj->mOpacity);
+    write(obj->mGradient);
+    write(obj->mColorPoints);
+    write(obj->mEnabled);
+}
+
+void BinaryWriter::writeText(const model::TextLayerData &text)
+{
+    count(text.mTextDocument.size());
+    for (const auto &e : text.mTextDocument) {
+        write(e.mTime);
+        write(e.mSize);
+        write(e.mFont);
+        write(e.mText.getUtf8Text());
+        pod(uint8_t(e.mJustification));
+        write(e.mTracking);
+        write(e.mLineHeight);
+        write(e.mBaselineShift);
+        write(e.mFillColor);
+        write(e.mStrokeColor);
+        write(e.mStrokeWidth);
+        write(e.mStrokeOverFill);
+    }
+    count(text.mTextAnimator.size());
+    for (const auto &e : text.mTextAnimator) {
+        write(e.mName);
+        count(e.mAnimatedProperties.size());
+        for (const auto &c : e.mAnimatedProperties) {
+            // the accessors of PropertyText are not const.
+            auto &prop = const_cast<model::PropertyText &>(c);
+            pod(uint8_t(prop.type()));
+            switch (prop.type()) {
+            case model::PropertyText::Type::Opacity:
+                write(prop.opacity());
+                break;
+            case model::PropertyText::Type::Rotation:
+                write(prop.rotation());
+                break;
+            case model::PropertyText::Type::Tracking:
+                write(prop.tracking());
+                break;
+            case model::PropertyText::Type::StrokeWidth:
+                write(prop.strokeWidth());
+                break;
+            case model::PropertyText::Type::Position:
+                write(prop.position());
+                break;
+            case model::PropertyText::Type::Scale:
+                write(prop.scale());
+                break;
+            case model::PropertyText::Type::Anchor:
+                write(prop.anchor());
+                break;
+            case model::PropertyText::Type::StrokeColor:
+                write(prop.strokeColor());
+                break;
+            case model::PropertyText::Type::FillColor:
+                write(prop.fillColor());
+                break;
+            }
+        }
+        write(e.mRangeType);
+        write(e.mRangeUnit);
+        write(e.mRangeStart);
+        write(e.mRangeEnd);
+        write(e.mHasRange);
+    }
+}
+
+void BinaryWriter::writeLayer(const model::Layer *obj)
+{
+    pod(uint8_t(obj->mMatteType));
+    pod(uint8_t(obj->mLayerType));
+    pod(uint8_t(obj->mBlendMode));
+    write(obj->mHasRoundedCorner);
+    write(obj->mHasPathOperator);
+    write(obj->mHasMask);
+    write(obj->mHasRepeater);
+    write(obj->mHasGradient);
+    write(obj->mAutoOrient);
+    write(obj->mLayerSize.width());
+    write(obj->mLayerSize.height());
+    write(obj->mParentId);
+    write(obj->mId);
+    write(obj->mTimeStreatch);
+    write(obj->mInFrame);
+    write(obj->mOutFrame);
+    write(obj->mStartFrame);
+
+    auto extra = obj->mExtra.get();
+    write(bool(extra));
+    if (extra) {
+        write(extra->mSolidColor);
+        write(extra->mPreCompRefId);
+        write(extra->mTimeRemap);
+        write(extra->mAsset ? extra->mAsset->mRefId : std::string());
+        count(extra->mMasks.size());
+        for (const auto &e : extra->mMasks) {
+            write(e->mShape);
+            write(e->mOpacity);
+            write(e->mInv);
+            write(e->mIsStatic);
+            pod(uint8_t(e->mMode));
+        }
+        write(bool(extra->mTextLayerData));
+        if (extra->mTextLayerData) writeText(*extra->mTextLayerData);
+    }
+    writeGroup(obj);
+}
+
+void BinaryWriter::write(const model::Object *obj)
+{
+    if (!obj) return pod(uint32_t(0));
+
+    auto search = mObjects.find(obj);
+    if (search != mObjects.end()) return pod(search->second);
+
+    auto id = uint32_t(mObjects.size() + 1);
+    mObjects[obj] = id;
+    pod(id);
+    pod(uint8_t(obj->type()));
+    write(obj->isStatic());
+    write(obj->hidden());
+    write(std::string(obj->name()));
+
+    switch (obj->type()) {
+    case model::Object::Type::Layer:
+        writeLayer(static_cast<const model::Layer *>(obj));
+        break;
+    case model::Object::Type::Group:
+        writeGroup(static_cast<const model::Group *>(obj));
+        break;
+    case model::Object::Type::Transform:
+        writeTransform(static_cast<const model::Transform *>(obj));
+        break;
+    case model::Object::Type::Fill: {
+        auto fill = static_cast<const model::Fill *>(obj);
+        pod(uint8_t(fill->mFillRule));
+        write(fill->mEnabled);
+        write(fill->mColor);
+        write(fill->mOpacity);
+        break;
+    }
+    case model::Object::Type::Stroke: {
+        auto stroke = static_cast<const model::Stroke *>(obj);
+        write(stroke->mColor);
+        write(stroke->mOpacity);
+        write(stroke->mWidth);
+        pod(uint8_t(stroke->mCapStyle));
+        pod(uint8_t(stroke->mJoinStyle));
+        write(stroke->mMiterLimit);
+        write(stroke->mDash);
+        write(stroke->mEnabled);
+        break;
+    }
+    case model::Object::Type::GFill: {
+        auto fill = static_cast<const model::GradientFill *>(obj);
+        writeGradient(fill);
+        pod(uint8_t(fill->mFillRule));
+        break;
+    }
+    case model::Object::Type::GStroke: {
+        auto stroke = static_cast<const model::GradientStroke *>(obj);
+        writeGradient(stroke);
+        write(stroke->mWidth);
+        pod(uint8_t(stroke->mCapStyle));
+        pod(uint8_t(stroke->mJoinStyle));
+        write(stroke->mMiterLimit);
+        write(stroke->mDash);
+        break;
+    }
+    case model::Object::Type::Rect: {
+        auto rect = static_cast<const model::Rect *>(obj);
+        write(rect->mDirection);
+        write(rect->mRoundedCorner);
+        write(rect->mPos);
+        write(rect->mSize);
+        write(rect->mRound);
+        break;
+    }
+    case model::Object::Type::Ellipse: {
+        auto ellipse = static_cast<const model::Ellipse *>(obj);
+        write(ellipse->mDirection);
+        write(ellipse->mPos);
+        write(ellipse->mSize);
+        break;
+    }
+    case model::Object::Type::Path: {
+        auto path = static_cast<const model::Path *>(obj);
+        write(path->mDirection);
+        write(path->mShape);
+        count(path->mMerged.size());
+        for (const auto &e : path->mMerged) write(e);
+        break;
+    }
+    case model::Object::Type::Polystar: {
+        auto star = static_cast<const model::Polystar *>(obj);
+        write(star->mDirection);
+        pod(uint8_t(star->mPolyType));
+        write(star->mPos);
+        write(star->mPointCount);
+        write(star->mInnerRadius);
+        write(star->mOuterRadius);
+        write(star->mInnerRoundness);
+        write(star->mOuterRoundness);
+        write(star->mRotation);
+        break;
+    }
+    case model::Object::Type::Trim: {
+        auto trim = static_cast<const model::Trim *>(obj);
+        write(trim->mStart);
+        write(trim->mEnd);
+        write(trim->mOffset);
+        pod(uint8_t(trim->mTrimType));
+        break;
+    }
+    case model::Object::Type::Repeater: {
+        auto repeater = static_cast<const model::Repeater *>(obj);
+        write(repeater->mContent);
+        write(repeater->mTransform.mRotation);
+        write(repeater->mTransform.mScale);
+        write(repeater->mTransform.mPosition);
+        write(repeater->mTransform.mAnchor);
+        write(repeater->mTransform.mStartOpacity);
+        write(repeater->mTransform.mEndOpacity);
+        write(repeater->mCopies);
+        write(repeater->mOffset);
+        write(repeater->mMaxCopies);
+        write(repeater->mProcessed);
+        break;
+    }
+    case model::Object::Type::RoundedCorner:
+        write(static_cast<const model::RoundedCorner *>(obj)->mRadius);
+        break;
+    default:
+        break;
+    }
+}
+
+void BinaryWriter::writeAsset(const model::Asset *asset)
+{
+    pod(uint8_t(asset->mAssetType));
+    write(asset->mStatic);
+    write(asset->mRefId);
+    count(asset->mLayers.size());
+    for (const auto &e : asset->mLayers) write(e);
+    write(asset->mWidth);
+    write(asset->mHeight);
+
+    // embedded images keep their encoded form and get decoded on first
+    // use, images of a file are stored decoded as the file may be gone.
+    if (!asset->imageData().empty()) {
+        pod(ImageStorage::Encoded);
+        write(asset->imageData());
+        return;
+    }
+    auto image = asset->bitmap();
+    if (!image) {
+        pod(ImageStorage::None);
+        return;
+    }
+    const auto &bitmap = *image;
+    pod(ImageStorage::Decoded);
+    pod(uint8_t(bitmap.format()));
+    count(bitmap.width());
+    count(bitmap.height());
+    auto rowSize = bitmap.width() * bitmap.depth() / 8;
+    for (size_t y = 0; y < bitmap.height(); y++) {
+        mOut.append(reinterpret_cast<const char *>(bitmap.data()) +
+                        y * bitmap.stride(),
+                    rowSize);
+    }
+}
+
+void BinaryWriter::write(const model::Composition &comp)
+{
+    mOut.append(BinaryMagic, sizeof(BinaryMagic));
+    pod(BinaryVersion);
+    pod(BinaryByteOrder);
+
+    write(comp.isStatic());
+    write(comp.mVersion);
+    write(comp.mSize.width());
+    write(comp.mSize.height());
+    pod(int64_t(comp.mStartFrame));
+    pod(int64_t(comp.mEndFrame));
+    write(comp.mFrameRate);
+    pod(uint8_t(comp.mBlendMode));
+
+    // assets first, the precomp layers refer to their layers. sorted to
+    // give the same output for the same resource.
+    std::vector<const model::Asset *> assets;
+    for (const auto &e : comp.mAssets) assets.push_back(e.second);
+    std::sort(assets.begin(), assets.end(),
+              [](const model::Asset *a, const model::Asset *b) {
+                  return a->mRefId < b->mRefId;
+              });
+    count(assets.size());
+    for (const auto &e : assets) writeAsset(e);
+
+    write(comp.mRootLayer);
+
+    count(comp.mIdenticalFrames.size());
+    for (const auto &e : comp.mIdenticalFrames) {
+        write(e.first);
+        write(e.second);
+    }
+
+    count(comp.mMarkers.size());
+    for (const auto &e : comp.mMarkers) {
+        write(std::get<0>(e));
+        write(std::get<1>(e));
+        write(std::get<2>(e));
+    }
+
+    count(comp.mFontDB.mFonts.size());
+    for (const auto &e : comp.mFontDB.mFonts) {
+        write(e.mFontName);
+        write(e.mFontFamily);
+        write(e.mFontStyle);
+        write(e.mFontAscent);
+    }
+    count(comp.mFontDB.mChars.size());
+    for (const auto &e : comp.mFontDB.mChars) {
+        write(e.mCh.getUtf8Text());
+        write(e.mStyle);
+        write(e.mFontFamily);
+        write(e.mSize);
+        write(e.mWidth);
+        write(e.mOutline);
+    }
+}
+
+class BinaryReader {
+public:
+    BinaryReader(const char *data, size_t length, model::ColorFilter filter)
+        : mData(data), mEnd(data + length), mColorFilter(std::move(filter))
+    {
+    }
+
+    bool failed() const { return mFailed; }
+
+    template <typename T>
+    T pod()
+    {
+        T value{};
+        if (size_t(mEnd - mData) < sizeof(T)) {
+            mFailed = true;
+            return value;
+        }
+        memcpy(&value, mData, sizeof(T));
+        mData += sizeof(T);
+        return value;
+    }
+    // enums take a byte, values out of their range are corrupt data.
+    template <typename T>
+    T enumeration(T first, T last)
+    {
+        auto value = pod<uint8_t>();
+        if (value < uint8_t(first) || value > uint8_t(last)) {
+            mFailed = true;
+            return first;
+        }
+        return T(value);
+    }
+    // every element takes at least a byte, bigger counts are corrupt data.
+    size_t count()
+    {
+        auto n = size_t(pod<uint32_t>());
+        if (n > size_t(mEnd - mData)) {
+            mFailed = true;
+            return 0;
+        }
+        return n;
+    }
+
+    void read(bool &value) { value = pod<uint8_t>(); }
+    void read(int &value) { value = pod<int32_t>(); }
+    void read(float &value) { value = pod<float>(); }
+    void read(double &value) { value = pod<double>(); }
+    void read(std::string &str)
+    {
+        auto n = count();
+        str.assign(mData, n);
+        mData += n;
+    }
+    void read(VPointF &pt)
+    {
+        auto x = pod<float>();
+        pt = VPointF(x, pod<float>());
+    }
+    // the parser applies the filter to every color property.
+    void read(model::Color &color)
+    {
+        readRaw(color);
+        if (mColorFilter) mColorFilter(color.r, color.g, color.b);
+    }
+    void readRaw(model::Color &color)
+    {
+        read(color.r);
+        read(color.g);
+        read(color.b);
+    }
+    void read(model::PathData &path)
+    {
+        auto n = count();
+        if (mFailed) return;
+        auto points = mComp->mArenaAlloc.makeArrayDefault<VPointF>(n);
+        for (size_t i = 0; i < n; i++) read(points[i]);
+        path.mPoints = {points, n};
+        read(path.mClosed);
+    }
+    void read(model::Gradient::Data &gradient)
+    {
+        gradient.mGradient.resize(count());
+        for (auto &e : gradient.mGradient) read(e);
+    }
+    void read(VPath &path)
+    {
+        std::vector<VPath::Element> elements(count());
+        for (auto &e : elements)
+            e = enumeration(VPath::Element::MoveTo, VPath::Element::Close);
+        std::vector<VPointF> points(count());
+        for (auto &e : points) read(e);
+        if (mFailed) return;
+
+        path.reset();
+        path.reserve(points.size(), elements.size());
+        size_t i = 0;
+        for (auto e : elements) {
+            size_t needed = (e == VPath::Element::CubicTo)
+                                ? 3
+                                : (e == VPath::Element::Close) ? 0 : 1;
+            if (i + needed > points.size()) {
+                mFailed = true;
+                return;
+            }
+            switch (e) {
+            case VPath::Element::MoveTo:
+                path.moveTo(points[i]);
+                break;
+            case VPath::Element::LineTo:
+                path.lineTo(points[i]);
+                break;
+            case VPath::Element::CubicTo:
+                path.cubicTo(points[i], points[i + 1], points[i + 2]);
+                break;
+            case VPath::Element::Close:
+                path.close();
+                break;
+            }
+            i += needed;
+        }
+    }
+    VMatrix readMatrix()
+    {
+        float m[9];
+        for (auto &e : m) read(e);
+        return VMatrix(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8]);
+    }
+
+    template <typename T>
+    void read(model::Value<T> &value)
+    {
+        read(value.start_);
+        read(value.end_);
+    }
+    template <typename T>
+    void read(model::Value<T, model::Position> &value)
+    {
+        read(value.start_);
+        read(value.end_);
+        read(value.inTangent_);
+        read(value.outTangent_);
+        read(value.length_);
+        read(value.hasTangent_);
+    }
+    template <typename T, typename Tag>
+    void read(model::Property<T, Tag> &prop)
+    {
+        bool isStatic;
+        read(isStatic);
+        if (isStatic) {
+            read(prop.value());
+            return;
+        }
+        auto &frames = prop.animation().keyFrames_;
+        frames.resize(count());
+        // the keyframe lookup needs at least one frame.
+        if (frames.empty()) mFailed = true;
+        for (auto &e : frames) {
+            read(e.start_);
+            read(e.end_);
+            e.interpolator_ = readInterpolator();
+            read(e.value_);
+            if (mFailed) return;
+        }
+        prop.freeze(mEasingTables, mComp->mArenaAlloc);
+    }
+    void read(model::Dash &dash)
+    {
+        auto n = count();
+        dash.mData.reserve(n);
+        for (size_t i = 0; i < n && !mFailed; i++) {
+            dash.mData.emplace_back();
+            read(dash.mData.back());
+        }
+    }
+
+    VInterpolator *readInterpolator()
+    {
+        auto id = pod<uint32_t>();
+        if (!id) return nullptr;
+        if (id <= mInterpolators.size()) return mInterpolators[id - 1];
+        if (id != mInterpolators.size() + 1) {
+            mFailed = true;
+            return nullptr;
+        }
+        VPointF p1, p2;
+        read(p1);
+        read(p2);
+        auto obj = mComp->mArenaAlloc.make<VInterpolator>(p1, p2);
+        mInterpolators.push_back(obj);
+        return obj;
+    }
+
+    model::Object *readObject();
+    std::shared_ptr<model::Composition> readComposition();
+
+private:
+    template <typename T>
+    T *make()
+    {
+        return mComp->mArenaAlloc.make<T>();
+    }
+    model::Object *create(model::Object::Type type);
+    void           readGroup(model::Group *obj, bool layers = false);
+    void           readLayer(model::Layer *obj);
+    void           readTransform(model::Transform *obj);
+    void           readGradient(model::Gradient *obj);
+    void           readText(model::TextLayerData &text);
+    void           readAsset(model::Asset *asset);
+
+    const char *                 mData;
+    const char *                 mEnd;
+    model::ColorFilter           mColorFilter;
+    model::Composition *         mComp{nullptr};
+    // the objects by index and whether they are completely read.
+    std::vector<std::pair<model::Object *, bool>> mObjects;
+    std::vector<VInterpolator *> mInterpolators;
+    model::EasingTables          mEasingTables;
+    // layers to point back to the composition and their image asset.
+    std::vector<std::pair<model::Layer *, std::string>> mLayerRefs;
+    int                                                 mDepth{0};
+    bool                                                mFailed{false};
+};
+
+model::Object *BinaryReader::create(model::Object::Type type)
+{
+    switch (type) {
+    case model::Object::Type::Layer:
+        return make<model::Layer>();
+    case model::Object::Type::Group:
+        return make<model::Group>();
+    case model::Object::Type::Transform:
+        return make<model::Transform>();
+    case model::Object::Type::Fill:
+        return make<model::Fill>();
+    case model::Object::Type::Stroke:
+        return make<model::Stroke>();
+    case model::Object::Type::GFill:
+        return make<model::GradientFill>();
+    case model::Object::Type::GStroke:
+        return make<model::GradientStroke>();
+    case model::Object::Type::Rect:
+        return make<model::Rect>();
+    case model::Object::Type::Ellipse:
+        return make<model::Ellipse>();
+    case model::Object::Type::Path:
+        return make<model::Path>();
+    case model::Object::Type::Polystar:
+        return make<model::Polystar>();
+    case model::Object::Type::Trim:
+        return make<model::Trim>();
+    case model::Object::Type::Repeater:
+        return make<model::Repeater>();
+    case model::Object::Type::RoundedCorner:
+        return make<model::RoundedCorner>();
+    default:
+        return nullptr;
+    }
+}
+
+void BinaryReader::readGroup(model::Group *obj, bool layers)
+{
+    auto n = count();
+    obj->mChildren.reserve(n);
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        auto child = readObject();
+        if (!child) continue;
+        // precomp layers hold layers, everything else shape objects.
+        if ((child->type() == model::Object::Type::Layer) != layers)
+            mFailed = true;
+        obj->mChildren.push_back(child);
+    }
+    auto transform = readObject();
+    if (transform && transform->type() != model::Object::Type::Transform)
+        mFailed = true;
+    else
+        obj->mTransform = static_cast<model::Transform *>(transform);
+}
+
+void BinaryReader::readTransform(model::Transform *obj)
+{
+    if (obj->isStatic()) {
+        auto matrix = readMatrix();
+        float opacity;
+        read(opacity);
+        obj->set(matrix, opacity);
+        return;
+    }
+    auto data = make<model::Transform::Data>();
+    read(data->mRotation);
+    read(data->mScale);
+    read(data->mPosition);
+    read(data->mAnchor);
+    read(data->mOpacity);
+    bool hasExtra;
+    read(hasExtra);
+    if (hasExtra) {
+        data->createExtraData();
+        auto extra = data->mExtra.get();
+        read(extra->m3DRx);
+        read(extra->m3DRy);
+        read(extra->m3DRz);
+        read(extra->mSeparateX);
+        read(extra->mSeparateY);
+        read(extra->mSeparate);
+        read(extra->m3DData);
+    }
+    obj->set(data, false);
+}
+
+void BinaryReader::readGradient(model::Gradient *obj)
+{
+    read(obj->mGradientType);
+    read(obj->mStartPoint);
+    read(obj->mEndPoint);
+    read(obj->mHighlightLength);
+    read(obj->mHighlightAngle);
+    read(obj->mOpacity);
+    read(obj->mGradient);
+    read(obj->mColorPoints);
+    read(obj->mEnabled);
+}
+
+void BinaryReader::readText(model::TextLayerData &text)
+{
+    auto n = count();
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        text.mTextDocument.emplace_back();
+        auto &e = text.mTextDocument.back();
+        read(e.mTime);
+        read(e.mSize);
+        read(e.mFont);
+        std::string utf8;
+        read(utf8);
+        e.mText.setUtf8Text(std::move(utf8));
+        e.mJustification = enumeration(model::Justification::Left,
+                                       model::Justification::Center);
+        read(e.mTracking);
+        read(e.mLineHeight);
+        read(e.mBaselineShift);
+        read(e.mFillColor);
+        read(e.mStrokeColor);
+        read(e.mStrokeWidth);
+        read(e.mStrokeOverFill);
+    }
+
+    n = count();
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        text.mTextAnimator.emplace_back();
+        auto &e = text.mTextAnimator.back();
+        read(e.mName);
+        auto props = count();
+        for (size_t j = 0; j < props && !mFailed; j++) {
+            auto type = model::PropertyText::Type(pod<uint8_t>());
+            if (type > model::PropertyText::Type::FillColor) {
+                mFailed = true;
+                break;
+            }
+            e.mAnimatedProperties.emplace_back(type);
+            auto &prop = e.mAnimatedProperties.back();
+            switch (type) {
+            case model::PropertyText::Type::Opacity:
+                read(prop.opacity());
+                break;
+            case model::PropertyText::Type::Rotation:
+                read(prop.rotation());
+                break;
+            case model::PropertyText::Type::Tracking:
+                read(prop.tracking());
+                break;
+            case model::PropertyText::Type::StrokeWidth:
+                read(prop.strokeWidth());
+                break;
+            case model::PropertyText::Type::Position:
+                read(prop.position());
+                break;
+            case model::PropertyText::Type::Scale:
+                read(prop.scale());
+                break;
+            case model::PropertyText::Type::Anchor:
+                read(prop.anchor());
+                break;
+            case model::PropertyText::Type::StrokeColor:
+                read(prop.strokeColor());
+                break;
+            case model::PropertyText::Type::FillColor:
+                read(prop.fillColor());
+                break;
+            }
+        }
+        read(e.mRangeType);
+        read(e.mRangeUnit);
+        read(e.mRangeStart);
+        read(e.mRangeEnd);
+        read(e.mHasRange);
+    }
+}
+
+void BinaryReader::readLayer(model::Layer *obj)
+{
+    obj->mMatteType =
+        enumeration(model::MatteType::None, model::MatteType::LumaInv);
+    obj->mLayerType =
+        enumeration(model::Layer::Type::Precomp, model::Layer::Type::Text);
+    obj->mBlendMode =
+        enumeration(model::BlendMode::Normal, model::BlendMode::OverLay);
+    read(obj->mHasRoundedCorner);
+    read(obj->mHasPathOperator);
+    read(obj->mHasMask);
+    read(obj->mHasRepeater);
+    read(obj->mHasGradient);
+    read(obj->mAutoOrient);
+    int width, height;
+    read(width);
+    read(height);
+    obj->mLayerSize = VSize(width, height);
+    read(obj->mParentId);
+    read(obj->mId);
+    read(obj->mTimeStreatch);
+    read(obj->mInFrame);
+    read(obj->mOutFrame);
+    read(obj->mStartFrame);
+
+    bool hasExtra;
+    read(hasExtra);
+    if (hasExtra) {
+        auto extra = obj->extra();
+        // the solid color is not a color property, no filter.
+        readRaw(extra->mSolidColor);
+        read(extra->mPreCompRefId);
+        read(extra->mTimeRemap);
+        std::string assetRefId;
+        read(assetRefId);
+        mLayerRefs.emplace_back(obj, std::move(assetRefId));
+
+        auto n = count();
+        for (size_t i = 0; i < n && !mFailed; i++) {
+            auto mask = make<model::Mask>();
+            read(mask->mShape);
+            read(mask->mOpacity);
+            read(mask->mInv);
+            read(mask->mIsStatic);
+            mask->mMode = enumeration(model::Mask::Mode::None,
+                                      model::Mask::Mode::Difference);
+            extra->mMasks.push_back(mask);
+        }
+        bool hasText;
+        read(hasText);
+        if (hasText) readText(*extra->textLayer());
+    }
+    // the text renderer needs a document.
+    if (obj->mLayerType == model::Layer::Type::Text &&
+        (!obj->mExtra || !obj->mExtra->mTextLayerData ||
+         obj->mExtra->mTextLayerData->mTextDocument.empty()))
+        mFailed = true;
+
+    readGroup(obj, obj->mLayerType == model::Layer::Type::Precomp);
+}
+
+model::Object *BinaryReader::readObject()
+{
+    auto id = pod<uint32_t>();
+    if (!id || mFailed) return nullptr;
+    if (id <= mObjects.size()) {
+        // an object still being read is an ancestor, the tree has a cycle.
+        if (!mObjects[id - 1].second) {
+            mFailed = true;
+            return nullptr;
+        }
+        return mObjects[id - 1].first;
+    }
+    if (id != mObjects.size() + 1 || mDepth >= MaxObjectDepth) {
+        mFailed = true;
+        return nullptr;
+    }
+
+    auto obj = create(model::Object::Type(pod<uint8_t>()));
+    if (!obj) {
+        mFailed = true;
+        return nullptr;
+    }
+    // register it first to keep the indices in the writer order.
+    auto index = mObjects.size();
+    mObjects.emplace_back(obj, false);
+
+    bool flag;
+    read(flag);
+    obj->setStatic(flag);
+    read(flag);
+    obj->setHidden(flag);
+    std::string name;
+    read(name);
+    if (!name.empty()) obj->setName(name.c_str());
+
+    mDepth++;
+    switch (obj->type()) {
+    case model::Object::Type::Layer:
+        readLayer(static_cast<model::Layer *>(obj));
+        break;
+    case model::Object::Type::Group:
+        readGroup(static_cast<model::Group *>(obj));
+        break;
+    case model::Object::Type::Transform:
+        readTransform(static_cast<model::Transform *>(obj));
+        break;
+    case model::Object::Type::Fill: {
+        auto fill = static_cast<model::Fill *>(obj);
+        fill->mFillRule = enumeration(FillRule::EvenOdd, FillRule::Winding);
+        read(fill->mEnabled);
+        read(fill->mColor);
+        read(fill->mOpacity);
+        break;
+    }
+    case model::Object::Type::Stroke: {
+        auto stroke = static_cast<model::Stroke *>(obj);
+        read(stroke->mColor);
+        read(stroke->mOpacity);
+        read(stroke->mWidth);
+        stroke->mCapStyle = enumeration(CapStyle::Flat, CapStyle::Round);
+        stroke->mJoinStyle = enumeration(JoinStyle::Miter, JoinStyle::Round);
+        read(stroke->mMiterLimit);
+        read(stroke->mDash);
+        read(stroke->mEnabled);
+        break;
+    }
+    case model::Object::Type::GFill: {
+        auto fill = static_cast<model::GradientFill *>(obj);
+        readGradient(fill);
+        fill->mFillRule = enumeration(FillRule::EvenOdd, FillRule::Winding);
+        break;
+    }
+    case model::Object::Type::GStroke: {
+        auto stroke = static_cast<model::GradientStroke *>(obj);
+        readGradient(stroke);
+        read(stroke->mWidth);
+        stroke->mCapStyle = enumeration(CapStyle::Flat, CapStyle::Round);
+        stroke->mJoinStyle = enumeration(JoinStyle::Miter, JoinStyle::Round);
+        read(stroke->mMiterLimit);
+        read(stroke->mDash);
+        break;
+    }
+    case model::Object::Type::Rect: {
+        auto rect = static_cast<model::Rect *>(obj);
+        read(rect->mDirection);
+        auto corner = readObject();
+        if (corner && corner->type() != model::Object::Type::RoundedCorner)
+            mFailed = true;
+        else
+            rect->mRoundedCorner = static_cast<model::RoundedCorner *>(corner);
+        read(rect->mPos);
+        read(rect->mSize);
+        read(rect->mRound);
+        break;
+    }
+    case model::Object::Type::Ellipse: {
+        auto ellipse = static_cast<model::Ellipse *>(obj);
+        read(ellipse->mDirection);
+        read(ellipse->mPos);
+        read(ellipse->mSize);
+        break;
+    }
+    case model::Object::Type::Path: {
+        auto path = static_cast<model::Path *>(obj);
+        read(path->mDirection);
+        read(path->mShape);
+        path->mMerged.resize(count());
+        for (auto &e : path->mMerged) read(e);
+        break;
+    }
+    case model::Object::Type::Polystar: {
+        auto star = static_cast<model::Polystar *>(obj);
+        read(star->mDirection);
+        star->mPolyType = enumeration(model::Polystar::PolyType::Star,
+                                      model::Polystar::PolyType::Polygon);
+        read(star->mPos);
+        read(star->mPointCount);
+        read(star->mInnerRadius);
+        read(star->mOuterRadius);
+        read(star->mInnerRoundness);
+        read(star->mOuterRoundness);
+        read(star->mRotation);
+        break;
+    }
+    case model::Object::Type::Trim: {
+        auto trim = static_cast<model::Trim *>(obj);
+        read(trim->mStart);
+        read(trim->mEnd);
+        read(trim->mOffset);
+        trim->mTrimType = enumeration(model::Trim::TrimType::Simultaneously,
+                                      model::Trim::TrimType::Individually);
+        break;
+    }
+    case model::Object::Type::Repeater: {
+        auto repeater = static_cast<model::Repeater *>(obj);
+        auto content = readObject();
+        // the renderer expects the content group.
+        if (!content || content->type() != model::Object::Type::Group)
+            mFailed = true;
+        else
+            repeater->setContent(static_cast<model::Group *>(content));
+        read(repeater->mTransform.mRotation);
+        read(repeater->mTransform.mScale);
+        read(repeater->mTransform.mPosition);
+        read(repeater->mTransform.mAnchor);
+        read(repeater->mTransform.mStartOpacity);
+        read(repeater->mTransform.mEndOpacity);
+        read(repeater->mCopies);
+        read(repeater->mOffset);
+        read(repeater->mMaxCopies);
+        read(repeater->mProcessed);
+        break;
+    }
+    case model::Object::Type::RoundedCorner:
+        read(static_cast<model::RoundedCorner *>(obj)->mRadius);
+        break;
+    default:
+        break;
+    }
+    mDepth--;
+    mObjects[index].second = true;
+
+    return mFailed ? nullptr : obj;
+}
+
+void BinaryReader::readAsset(model::Asset *asset)
+{
+    asset->mAssetType =
+        enumeration(model::Asset::Type::Precomp, model::Asset::Type::Char);
+    read(asset->mStatic);
+    read(asset->mRefId);
+    auto n = count();
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        auto layer = readObject();
+        if (!layer) continue;
+        if (layer->type() != model::Object::Type::Layer) mFailed = true;
+        asset->mLayers.push_back(layer);
+    }
+    read(asset->mWidth);
+    read(asset->mHeight);
+
+    auto storage = pod<ImageStorage>();
+    if (mFailed || storage == ImageStorage::None) return;
+    if (storage == ImageStorage::Encoded) {
+        std::string data;
+        read(data);
+        asset->loadImageData(std::move(data));
+        return;
+    }
+    if (storage != ImageStorage::Decoded) {
+        mFailed = true;
+        return;
+    }
+
+    auto format = VBitmap::Format(pod<uint8_t>());
+    auto width = count();
+    auto height = count();
+    if (format != VBitmap::Format::Alpha8 && format != VBitmap::Format::ARGB32 &&
+        format != VBitmap::Format::ARGB32_Premultiplied) {
+        mFailed = true;
+        return;
+    }
+    // the pixels must be there before the bitmap gets allocated.
+    size_t pixelSize = format == VBitmap::Format::Alpha8 ? 1 : 4;
+    if (!width || !height || width > size_t(mEnd - mData) / pixelSize / height) {
+        mFailed = true;
+        return;
+    }
+    auto    rowSize = width * pixelSize;
+    VBitmap bitmap(width, height, format);
+    for (size_t y = 0; y < height; y++) {
+        memcpy(bitmap.data() + y * bitmap.stride(), mData, rowSize);
+        mData += rowSize;
+    }
+    asset->setBitmap(std::move(bitmap));
+}
+
+std::shared_ptr<model::Composition> BinaryReader::readComposition()
+{
+    char magic[sizeof(BinaryMagic)];
+    for (auto &e : magic) e = pod<char>();
+    if (memcmp(magic, BinaryMagic, sizeof(BinaryMagic))) return {};
+
+    auto version = pod<uint16_t>();
+    auto byteOrder = pod<uint16_t>();
+    if (version != BinaryVersion) {
+        vWarning << "Unsupported precompiled model version : " << version;
+        return {};
+    }
+    if (byteOrder != BinaryByteOrder) {
+        vWarning << "Precompiled model written with another byte order";
+        return {};
+    }
+
+    auto composition = std::make_shared<model::Composition>();
+    mComp = composition.get();
+
+    bool isStatic;
+    read(isStatic);
+    mComp->setStatic(isStatic);
+    read(mComp->mVersion);
+    int width, height;
+    read(width);
+    read(height);
+    mComp->mSize = VSize(width, height);
+    mComp->mStartFrame = long(pod<int64_t>());
+    mComp->mEndFrame = long(pod<int64_t>());
+    read(mComp->mFrameRate);
+    mComp->mBlendMode =
+        enumeration(model::BlendMode::Normal, model::BlendMode::OverLay);
+
+    auto n = count();
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        auto asset = make<model::Asset>();
+        readAsset(asset);
+        mComp->mAssets[asset->mRefId] = asset;
+    }
+
+    auto root = readObject();
+    if (!root || root->type() != model::Object::Type::Layer) mFailed = true;
+    mComp->mRootLayer = static_cast<model::Layer *>(root);
+
+    n = count();
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        int first, last;
+        read(first);
+        read(last);
+        mComp->mIdenticalFrames.emplace_back(first, last);
+    }
+
+    n = count();
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        std::string name;
+        int         start, end;
+        read(name);
+        read(start);
+        read(end);
+        mComp->mMarkers.emplace_back(std::move(name), start, end);
+    }
+
+    n = count();
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        mComp->mFontDB.mFonts.emplace_back();
+        auto &e = mComp->mFontDB.mFonts.back();
+        read(e.mFontName);
+        read(e.mFontFamily);
+        read(e.mFontStyle);
+        read(e.mFontAscent);
+    }
+    n = count();
+    for (size_t i = 0; i < n && !mFailed; i++) {
+        mComp->mFontDB.mChars.emplace_back();
+        auto &e = mComp->mFontDB.mChars.back();
+        std::string utf8;
+        read(utf8);
+        e.mCh.setUtf8Text(std::move(utf8));
+        read(e.mStyle);
+        read(e.mFontFamily);
+        read(e.mSize);
+        read(e.mWidth);
+        read(e.mOutline);
+    }
+
+    if (mFailed || mData != mEnd) {
+        vWarning << "Precompiled model data is corrupted";
+        return {};
+    }
+
+    for (const auto &e : mLayerRefs) {
+        auto extra = e.first->extra();
+        extra->mCompRef = mComp;
+        if (e.second.empty()) continue;
+        auto search = mComp->mAssets.find(e.second);
+        if (search != mComp->mAssets.end()) extra->mAsset = search->second;
+    }
+    mComp->updateStats();
+
+    return composition;
+}
+
+}  // namespace
+
+bool model::isBinary(const char *data, size_t length)
+{
+    return length >= BinaryHeaderSize &&
+           !memcmp(data, BinaryMagic, sizeof(BinaryMagic));
+}
+
+std::string model::serialize(const model::Composition &comp)
+{
+    if (!comp.mRootLayer) return {};
+
+    BinaryWriter writer;
+    writer.write(comp);
+    return writer.result();
+}
+
+std::shared_ptr<model::Composition> model::deserialize(const char *data,
+                                                       size_t      length,
+                                                       ColorFilter filter)
+{
+    if (!isBinary(data, length)) return {};
+
+    BinaryReader reader(data, length, std::move(filter));
+    return reader.readComposition();
+}
@@ -117,12 +117,28 @@ void renderer::Composition::setValue(const std::string &keypath,
     mRootLayer->resolveKeyPath(key, 0, value);
 }
 
+renderer::MemoryStats renderer::Composition::memoryStats() const
+{
+    renderer::MemoryStats stats;
+    mRootLayer->memoryUsage(stats);
+    stats.surfaces += mSurfaceCache.memoryUsage();
+    for (const auto &e : mBandCaches) stats.surfaces += e.memoryUsage();
+    stats.arena += mAllocator.allocatedBytes();
+    return stats;
+}
+
+void renderer::Composition::releaseImages()
+{
+    mRootLayer->releaseImages();
+}
+
 bool renderer::Composition::update(int frameNo, const VSize &size,
                                    bool keepAspectRatio)
 {
-    // check if cached frame is same as requested frame.
-    if (!mHasDynamicValue && (mViewSize == size) && (mCurFrameNo == frameNo) &&
-        (mKeepAspectRatio == keepAspectRatio))
+    // check if cached frame has the same content as requested frame.
+    if (!mHasDynamicValue && (mViewSize == size) &&
+        (mKeepAspectRatio == keepAspectRatio) &&
+        mModel->isFrameIdentical(mCurFrameNo, frameNo))
         return false;
 
     mViewSize = size;
@@ -151,7 +167,158 @@ bool renderer::Composition::update(int frameNo, const VSize &size,
     return true;
 }
 
-bool renderer::Composition::render(const rlottie::Surface &surface)
+#ifdef LOTTIE_THREAD_SUPPORT
+
+#include <thread>
+#include "vexecutor.h"
+#include "vtaskqueue.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sstream>
+#endif
+
+using BandTask = std::function<void()>;
+
+class BandTaskScheduler {
+    const unsigned _count{VExecutor::threadCount(VExecutor::Pool::Band)};
+    std::vector<std::thread>         _threads;
+    std::vector<TaskQueue<BandTask>> _q{_count};
+    std::atomic<unsigned>            _index{0};
+
+    void run(unsigned i)
+    {
+        // Create Thread Name for Debugging (Linux)
+#ifdef __linux__
+        std::ostringstream nameStream;
+        nameStream << "lottie-bnd-" << i;
+        pthread_setname_np(pthread_self(), nameStream.str().c_str());
+#endif
+        VExecutor::applyAffinity(i);
+
+        while (true) {
+            bool     success = false;
+            BandTask task;
+            for (unsigned n = 0; n != _count * 2; ++n) {
+                if (_q[(i + n) % _count].try_pop(task)) {
+                    success = true;
+                    break;
+                }
+            }
+            if (!success && !_q[i].pop(task)) break;
+
+            task();
+        }
+    }
+
+    BandTaskScheduler()
+    {
+        for (unsigned n = 0; n != _count; ++n) {
+            _threads.emplace_back([&, n] { run(n); });
+        }
+
+        IsRunning = true;
+    }
+
+    void process(BandTask task)
+    {
+        if (!_count || !IsRunning) {
+            task();
+            return;
+        }
+
+        auto i = _index++;
+
+        for (unsigned n = 0; n != _count; ++n) {
+            if (_q[(i + n) % _count].try_push(std::move(task))) return;
+        }
+
+        _q[i % _count].push(std::move(task));
+    }
+
+public:
+    static bool IsRunning;
+
+    static BandTaskScheduler &instance()
+    {
+        static BandTaskScheduler singleton;
+        return singleton;
+    }
+
+    ~BandTaskScheduler() { stop(); }
+
+    void stop()
+    {
+        if (IsRunning) {
+            IsRunning = false;
+
+            for (auto &e : _q) e.done();
+            for (auto &e : _threads) e.join();
+        }
+    }
+
+    static void parallelFor(size_t begin, size_t end,
+                            const std::function<void(size_t)> &fn)
+    {
+        bool external = VExecutor::external();
+        VExecutor::parallelFor(begin, end, fn, [&](BandTask task) {
+            if (external)
+                VExecutor::submit(std::move(task));
+            else
+                instance().process(std::move(task));
+        });
+    }
+};
+
+#else
+
+class BandTaskScheduler {
+public:
+    static bool IsRunning;
+
+    static BandTaskScheduler &instance()
+    {
+        static BandTaskScheduler singleton;
+        return singleton;
+    }
+
+    void stop() {}
+
+    static void parallelFor(size_t begin, size_t end,
+                            const std::function<void(size_t)> &fn)
+    {
+        for (size_t i = begin; i < end; i++) fn(i);
+    }
+};
+
+#endif
+
+bool BandTaskScheduler::IsRunning{false};
+
+void lottieShutdownBandTaskScheduler()
+{
+    if (BandTaskScheduler::IsRunning) {
+        BandTaskScheduler::instance().stop();
+    }
+}
+
+// bands smaller than this are not worth a worker.
+static constexpr int MinBandHeight = 32;
+
+void renderer::Composition::renderBand(const VRect &region, const VRect &band,
+                                       SurfaceCache &cache)
+{
+    VPainter painter;
+    painter.begin(&mSurface, band);
+    // set sub surface area for drawing.
+    painter.setDrawRegion(region);
+    painter.setClipRect(band.translated(-region.x(), -region.y()));
+    mRootLayer->render(&painter, {}, {}, cache);
+    painter.end();
+}
+
+bool renderer::Composition::render(const rlottie::Surface &surface,
+                                   const std::atomic<bool> *cancelled)
 {
     mSurface.reset(reinterpret_cast<uint8_t *>(surface.buffer()),
                    uint32_t(surface.width()), uint32_t(surface.height()),
@@ -164,16 +331,85 @@ bool renderer::Composition::render(const rlottie::Surface &surface)
                int(surface.drawRegionHeight()));
     mRootLayer->preprocess(clip);
 
-    VPainter painter(&mSurface);
-    // set sub surface area for drawing.
-    painter.setDrawRegion(
-        VRect(int(surface.drawRegionPosX()), int(surface.drawRegionPosY()),
-              int(surface.drawRegionWidth()), int(surface.drawRegionHeight())));
-    mRootLayer->render(&painter, {}, {}, mSurfaceCache);
-    painter.end();
+    if (cancelled && cancelled->load()) {
+        // the surface is left as is, the next render redraws all of it.
+        invalidateDamage();
+        return false;
+    }
+
+    VRect region(int(surface.drawRegionPosX()), int(surface.drawRegionPosY()),
+                 int(surface.drawRegionWidth()),
+                 int(surface.drawRegionHeight()));
+
+    updateDamage(surface, region);
+
+    // the surface still holds the previous frame, only redraw the rows
+    // that changed. Spans clipped inside a row can blend gradients one
+    // rounding step apart from a full redraw, whole rows give the same
+    // pixels.
+    VRect area(0, 0, int(surface.width()), int(surface.height()));
+    if (mPartialRedraw) {
+        if (mDamage.empty()) return true;
+        area = VRect(0, mDamage.y(), area.width(), mDamage.height());
+    }
+
+    size_t bands = std::min(mBandCount, size_t(area.height() / MinBandHeight));
+
+    if (bands < 2) {
+        renderBand(region, area, mSurfaceCache);
+        return true;
+    }
+
+    auto bandRect = [&](size_t i) {
+        int top = int(area.height() * i / bands);
+        int bottom = int(area.height() * (i + 1) / bands);
+        return VRect(area.x(), area.y() + top, area.width(), bottom - top);
+    };
+
+    /* The first band is rendered on the calling thread before the others
+     * are dispatched. It resolves the state of the tree that is computed
+     * lazily (pending rle tasks, mask rle cache, rle bounding box) so that
+     * the remaining bands only read the shared data.
+     */
+    renderBand(region, bandRect(0), mSurfaceCache);
+
+    if (mBandCaches.size() < bands - 1) mBandCaches.resize(bands - 1);
+
+    BandTaskScheduler::parallelFor(1, bands, [&](size_t i) {
+        renderBand(region, bandRect(i), mBandCaches[i - 1]);
+    });
+
     return true;
 }
 
+static bool sameSurface(const rlottie::Surface &a, const rlottie::Surface &b)
+{
+    return a.buffer() == b.buffer() && a.width() == b.width() &&
+           a.height() == b.height() && a.bytesPerLine() == b.bytesPerLine() &&
+           a.drawRegionPosX() == b.drawRegionPosX() &&
+           a.drawRegionPosY() == b.drawRegionPosY() &&
+           a.drawRegionWidth() == b.drawRegionWidth() &&
+           a.drawRegionHeight() == b.drawRegionHeight();
+}
+
+void renderer::Composition::updateDamage(const rlottie::Surface &surface,
+                                         const VRect &            region)
+{
+    VRect damage;
+    mRootLayer->collectDamage(damage);
+
+    // pixels outside the content drawn in this or the previous frame stay
+    // cleared, so only that content can differ.
+    if (!sameSurface(mLastSurface, surface)) {
+        mDamage = VRect(0, 0, int(surface.width()), int(surface.height()));
+        mLastSurface = surface;
+        return;
+    }
+
+    damage = damage & VRect(0, 0, region.width(), region.height());
+    mDamage = damage.translated(region.x(), region.y());
+}
+
 void renderer::Mask::update(int frameNo, const VMatrix &parentMatrix,
                             float /*parentAlpha*/, const DirtyFlag &flag)
 {
@@ -261,6 +497,20 @@ void renderer::Layer::render(VPainter *painter, const VRle &inheritMask,
     }
 }
 
+VRect renderer::Layer::collectDamage(VRect &damage)
+{
+    VRect bounds;
+    for (auto &i : renderList()) bounds = bounds.united(i->rle().boundingRect());
+
+    if (mContentChanged || bounds != mDrawnRect) {
+        damage = damage.united(mDrawnRect).united(bounds);
+    }
+    mDrawnRect = bounds;
+    mContentChanged = false;
+
+    return bounds;
+}
+
 void renderer::LayerMask::preprocess(const VRect &clip)
 {
     for (auto &i : mMasks) {
@@ -363,6 +613,17 @@ bool renderer::Layer::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
     return true;
 }
 
+void renderer::Layer::memoryUsage(MemoryStats &stats) const
+{
+    if (mCApiData) stats.renderTree += mCApiData->memoryUsage();
+    if (!mLayerMask) return;
+
+    for (const auto &e : mLayerMask->mMasks)
+        stats.rles += e.mRasterizer.memoryUsage();
+    // a single mask shares its rle with the rasterizer.
+    if (mLayerMask->mRle.unique()) stats.rles += mLayerMask->mRle.memoryUsage();
+}
+
 bool renderer::ShapeLayer::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
                                           LOTVariant &value)
 {
@@ -426,6 +687,11 @@ void renderer::Layer::update(int frameNumber, const VMatrix &parentMatrix,
                            mDirtyFlag);
     }
 
+    // remember the change till the damage of the frame is collected.
+    if (!flag().testFlag(DirtyFlagBit::None) ||
+        (mLayerMask && !mLayerMask->isStatic()))
+        mContentChanged = true;
+
     // 5. if no parent property change and layer is static then nothing to do.
     if (!mLayerData->precompLayer() && flag().testFlag(DirtyFlagBit::None) &&
         isStatic())
@@ -433,6 +699,8 @@ void renderer::Layer::update(int frameNumber, const VMatrix &parentMatrix,
 
     // 6. update the content of the layer
     updateContent();
+    // a precomp only changes through its children.
+    if (!mLayerData->precompLayer()) mContentChanged = true;
 
     // 7. reset the dirty flag
     mDirtyFlag = DirtyFlagBit::None;
@@ -508,7 +776,7 @@ void renderer::CompLayer::render(VPainter *painter, const VRle &inheritMask,
             VSize    size = painter->clipBoundingRect().size();
             VPainter srcPainter;
             VBitmap srcBitmap = cache.make_surface(size.width(), size.height());
-            srcPainter.begin(&srcBitmap);
+            srcPainter.begin(&srcBitmap, painter->clipRect());
             renderHelper(&srcPainter, inheritMask, matteRle, cache);
             srcPainter.end();
             painter->drawBitmap(VPoint(), srcBitmap,
@@ -520,6 +788,57 @@ void renderer::CompLayer::render(VPainter *painter, const VRle &inheritMask,
     }
 }
 
+void renderer::CompLayer::releaseImages()
+{
+    for (const auto &layer : mLayers) layer->releaseImages();
+}
+
+void renderer::CompLayer::memoryUsage(MemoryStats &stats) const
+{
+    renderer::Layer::memoryUsage(stats);
+    if (mClipper) stats.rles += mClipper->mRasterizer.memoryUsage();
+    for (const auto &layer : mLayers) layer->memoryUsage(stats);
+}
+
+VRect renderer::CompLayer::collectDamage(VRect &damage)
+{
+    VRect bounds;
+    VRect childDamage;
+
+    if (!skipRendering()) {
+        renderer::Layer *matte = nullptr;
+        for (const auto &layer : mLayers) {
+            if (layer->hasMatte()) {
+                matte = layer;
+            } else {
+                if (matte) {
+                    // a change in the matte source changes the pixels of
+                    // the layer it is applied to.
+                    VRect pairDamage;
+                    auto  layerBounds = matte->collectDamage(pairDamage);
+                    layer->collectDamage(pairDamage);
+                    if (!pairDamage.empty())
+                        childDamage =
+                            childDamage.united(pairDamage).united(layerBounds);
+                    bounds = bounds.united(layerBounds);
+                } else {
+                    bounds = bounds.united(layer->collectDamage(childDamage));
+                }
+                matte = nullptr;
+            }
+        }
+    }
+
+    if (mContentChanged || bounds != mDrawnRect) {
+        damage = damage.united(mDrawnRect).united(bounds);
+    }
+    damage = damage.united(childDamage);
+    mDrawnRect = bounds;
+    mContentChanged = false;
+
+    return bounds;
+}
+
 void renderer::CompLayer::renderHelper(VPainter *    painter,
                                        const VRle &  inheritMask,
                                        const VRle &  matteRle,
@@ -570,14 +889,14 @@ void renderer::CompLayer::renderMatteLayer(VPainter *painter, const VRle &mask,
     // 1. draw src layer to matte buffer
     VPainter srcPainter;
     VBitmap  srcBitmap = cache.make_surface(size.width(), size.height());
-    srcPainter.begin(&srcBitmap);
+    srcPainter.begin(&srcBitmap, painter->clipRect());
     src->render(&srcPainter, mask, matteRle, cache);
     srcPainter.end();
 
     // 2. draw layer to layer buffer
     VPainter layerPainter;
     VBitmap  layerBitmap = cache.make_surface(size.width(), size.height());
-    layerPainter.begin(&layerBitmap);
+    layerPainter.begin(&layerBitmap, painter->clipRect());
     layer->render(&layerPainter, mask, matteRle, cache);
 
     // 2.1update composition mode
@@ -641,9 +960,9 @@ VRle renderer::Clipper::rle(const VRle &mask)
 {
     if (mask.empty()) return mRasterizer.rle();
 
-    mMaskedRle.clone(mask);
-    mMaskedRle &= mRasterizer.rle();
-    return mMaskedRle;
+    // don't keep the result around, the layer can be rendered by more
+    // than one band at the same time.
+    return mask & mRasterizer.rle();
 }
 
 void renderer::CompLayer::updateContent()
@@ -720,6 +1039,12 @@ renderer::DrawableList renderer::SolidLayer::renderList()
     return {&mDrawableList, 1};
 }
 
+void renderer::SolidLayer::memoryUsage(MemoryStats &stats) const
+{
+    renderer::Layer::memoryUsage(stats);
+    mRenderNode.memoryUsage(stats);
+}
+
 renderer::ImageLayer::ImageLayer(model::Layer *layerData)
     : renderer::Layer(layerData)
 {
@@ -727,11 +1052,22 @@ renderer::ImageLayer::ImageLayer(model::Layer *layerData)
 
     if (!mLayerData->asset()) return;
 
-    mTexture.mBitmap = mLayerData->asset()->bitmap();
     VBrush brush(&mTexture);
     mRenderNode.setBrush(brush);
 }
 
+void renderer::ImageLayer::loadImage()
+{
+    if (mImage || !mLayerData->asset()) return;
+
+    mImage = mLayerData->asset()->bitmap();
+    if (!mImage) return;
+    // a bitmap of its own over the shared pixels.
+    mTexture.mBitmap = VBitmap(mImage->data(), mImage->width(),
+                               mImage->height(), mImage->stride(),
+                               mImage->format());
+}
+
 void renderer::ImageLayer::updateContent()
 {
     if (!mLayerData->asset()) return;
@@ -753,6 +1089,8 @@ void renderer::ImageLayer::updateContent()
 
 void renderer::ImageLayer::preprocessStage(const VRect &clip)
 {
+    // the image is decoded the first time the layer gets drawn.
+    loadImage();
     mRenderNode.preprocess(clip);
 }
 
@@ -763,6 +1101,12 @@ renderer::DrawableList renderer::ImageLayer::renderList()
     return {&mDrawableList, 1};
 }
 
+void renderer::ImageLayer::memoryUsage(MemoryStats &stats) const
+{
+    renderer::Layer::memoryUsage(stats);
+    mRenderNode.memoryUsage(stats);
+}
+
 renderer::NullLayer::NullLayer(model::Layer *layerData)
     : renderer::Layer(layerData)
 {
@@ -842,6 +1186,7 @@ renderer::ShapeLayer::ShapeLayer(model::Layer *layerData,
 void renderer::ShapeLayer::updateContent()
 {
     mRoot->update(frameNo(), combinedMatrix(), 1.0f , flag());
+    mDrawableListDirty = true;
 
     if (mLayerData->hasPathOperator()) {
         mRoot->applyTrim();
@@ -850,18 +1195,22 @@ void renderer::ShapeLayer::updateContent()
 
 void renderer::ShapeLayer::preprocessStage(const VRect &clip)
 {
-    mDrawableList.clear();
-    mRoot->renderList(mDrawableList);
+    auto renderlist = renderList();
 
-    for (auto &drawable : mDrawableList) drawable->preprocess(clip);
+    for (auto &drawable : renderlist) drawable->preprocess(clip);
 }
 
 renderer::DrawableList renderer::ShapeLayer::renderList()
 {
     if (skipRendering()) return {};
 
-    mDrawableList.clear();
-    mRoot->renderList(mDrawableList);
+    // the list only changes when the content is updated, rebuilding it
+    // later would race with the bands that are iterating it.
+    if (mDrawableListDirty) {
+        mDrawableList.clear();
+        mRoot->renderList(mDrawableList);
+        mDrawableListDirty = false;
+    }
 
     if (mDrawableList.empty()) return {};
 
@@ -880,7 +1229,7 @@ void renderer::ShapeLayer::render(VPainter *painter, const VRle &inheritMask,
         VSize    size = painter->clipBoundingRect().size();
         VPainter srcPainter;
         VBitmap srcBitmap = cache.make_surface(size.width(), size.height());
-        srcPainter.begin(&srcBitmap);
+        srcPainter.begin(&srcBitmap, painter->clipRect());
         Layer::render(&srcPainter, inheritMask, matteRle, cache);
         srcPainter.end();
         painter->drawBitmap(VPoint(), srcBitmap,
@@ -888,6 +1237,12 @@ void renderer::ShapeLayer::render(VPainter *painter, const VRle &inheritMask,
         cache.release_surface(srcBitmap);
     }
 }
+
+void renderer::ShapeLayer::memoryUsage(MemoryStats &stats) const
+{
+    renderer::Layer::memoryUsage(stats);
+    if (mRoot) mRoot->memoryUsage(stats);
+}
                                          
 renderer::TextLayer::TextLayer(model::Layer *layerData, VArenaAlloc *allocator)
     : renderer::Layer(layerData),
@@ -903,6 +1258,7 @@ void renderer::TextLayer::updateContent()
     int                         index = 0, numOfIndex;
 
     mRenderNode.clear();
+    mDrawableListDirty = true;
 
     updateTextPath(frameNo());
     getTextData(data, frameNo());
@@ -953,7 +1309,6 @@ void renderer::TextLayer::updateContent()
 
 void renderer::TextLayer::preprocessStage(const VRect &clip)
 {
-    mDrawableList.clear();
     auto renderlist = renderList();
 
     for (auto &drawable : renderlist) drawable->preprocess(clip);
@@ -977,12 +1332,22 @@ renderer::DrawableList renderer::TextLayer::renderList()
 {
     if (skipRendering()) return {};
 
-    for (auto &renderNode : mRenderNode)
-        mDrawableList.emplace_back((VDrawable *)renderNode.get());
+    if (mDrawableListDirty) {
+        mDrawableList.clear();
+        for (auto &renderNode : mRenderNode)
+            mDrawableList.emplace_back((VDrawable *)renderNode.get());
+        mDrawableListDirty = false;
+    }
 
     return {mDrawableList.data(), mDrawableList.size()};
 }
 
+void renderer::TextLayer::memoryUsage(MemoryStats &stats) const
+{
+    renderer::Layer::memoryUsage(stats);
+    for (const auto &e : mRenderNode) e->memoryUsage(stats);
+}
+
 bool renderer::Fill::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
                                     LOTVariant &value)
 {
@@ -1067,6 +1432,11 @@ void renderer::Group::update(int frameNo, const VMatrix &parentMatrix,
     }
 }
 
+void renderer::Group::memoryUsage(MemoryStats &stats) const
+{
+    for (const auto &content : mContents) content->memoryUsage(stats);
+}
+
 bool renderer::Group::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth, LOTVariant &value)
 {
     if (!keyPath.skip(name())) {
@@ -1258,6 +1628,13 @@ renderer::Path::Path(model::Path *data)
 void renderer::Path::updatePath(VPath &path, int frameNo)
 {
     mData->mShape.value(frameNo, path);
+    if (mData->mMerged.empty()) return;
+
+    size_t points = 0;
+    for (const auto &e : mData->mMerged) points += e.mPoints.size();
+    path.reserve(points + mData->mMerged.size(),
+                 points / 3 + 2 * mData->mMerged.size());
+    for (const auto &e : mData->mMerged) e.addTo(path);
 }
 
 renderer::Polystar::Polystar(model::Polystar *data)
@@ -1344,6 +1721,20 @@ void renderer::Paint::renderList(std::vector<VDrawable *> &list)
     if (mContentToRender) list.push_back(&mDrawable);
 }
 
+void renderer::Drawable::memoryUsage(MemoryStats &stats) const
+{
+    stats.rles += mRasterizer.memoryUsage();
+    if (!mCNode) return;
+
+    stats.renderTree += sizeof(LOTNode) +
+                        mCNode->mGradient.stopCount * sizeof(LOTGradientStop);
+}
+
+void renderer::Paint::memoryUsage(MemoryStats &stats) const
+{
+    mDrawable.memoryUsage(stats);
+}
+
 void renderer::Paint::addPathItems(std::vector<renderer::Shape *> &list,
                                    size_t                          startOffset)
 {
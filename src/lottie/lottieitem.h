@@ -23,6 +23,7 @@
 #ifndef LOTTIEITEM_H
 #define LOTTIEITEM_H
 
+#include <atomic>
 #include <memory>
 #include <sstream>
 
@@ -44,38 +45,6 @@ namespace rlottie {
 
 namespace internal {
 
-template <class T>
-class VSpan {
-public:
-    using reference = T &;
-    using pointer = T *;
-    using const_pointer = T const *;
-    using const_reference = T const &;
-    using index_type = size_t;
-
-    using iterator = pointer;
-    using const_iterator = const_pointer;
-
-    VSpan() = default;
-    VSpan(pointer data, index_type size) : _data(data), _size(size) {}
-
-    constexpr pointer        data() const noexcept { return _data; }
-    constexpr index_type     size() const noexcept { return _size; }
-    constexpr bool           empty() const noexcept { return size() == 0; }
-    constexpr iterator       begin() const noexcept { return data(); }
-    constexpr iterator       end() const noexcept { return data() + size(); }
-    constexpr const_iterator cbegin() const noexcept { return data(); }
-    constexpr const_iterator cend() const noexcept { return data() + size(); }
-    constexpr reference      operator[](index_type idx) const
-    {
-        return *(data() + idx);
-    }
-
-private:
-    pointer    _data{nullptr};
-    index_type _size{0};
-};
-
 namespace renderer {
 
 using DrawableList = VSpan<VDrawable *>;
@@ -88,6 +57,14 @@ enum class DirtyFlagBit : uint8_t {
 };
 typedef vFlag<DirtyFlagBit> DirtyFlag;
 
+// bytes held by a render tree, see Composition::memoryStats().
+struct MemoryStats {
+    size_t rles{0};        // spans of the rasterized paths, masks and clips
+    size_t surfaces{0};    // offscreen bitmaps kept for reuse
+    size_t renderTree{0};  // nodes of the C api render tree
+    size_t arena{0};       // arena blocks holding the render objects
+};
+
 class SurfaceCache {
 public:
     SurfaceCache() { mCache.reserve(10); }
@@ -107,6 +84,13 @@ public:
 
     void release_surface(VBitmap &surface) { mCache.push_back(surface); }
 
+    size_t memoryUsage() const
+    {
+        size_t bytes = 0;
+        for (const auto &e : mCache) bytes += e.stride() * e.height();
+        return bytes;
+    }
+
 private:
     std::vector<VBitmap> mCache;
 };
@@ -114,6 +98,7 @@ private:
 class Drawable final : public VDrawable {
 public:
     void sync();
+    void memoryUsage(MemoryStats &stats) const;
 
 public:
     std::unique_ptr<LOTNode> mCNode{nullptr};
@@ -127,6 +112,7 @@ public:
 
 struct CApiData {
     CApiData();
+    size_t                      memoryUsage() const;
     LOTLayerNode                mLayer;
     std::vector<LOTMask>        mMasks;
     std::vector<LOTLayerNode *> mLayers;
@@ -143,7 +129,6 @@ public:
 public:
     VSize       mSize;
     VPath       mPath;
-    VRle        mMaskedRle;
     VRasterizer mRasterizer;
     bool        mRasterRequest{false};
 };
@@ -194,18 +179,41 @@ public:
     VSize size() const { return mViewSize; }
     void  buildRenderTree();
     const LOTLayerNode *renderTree() const;
-    bool                render(const rlottie::Surface &surface);
+    // returns false if the render got cancelled before the blending.
+    bool                render(const rlottie::Surface &surface,
+                               const std::atomic<bool> *cancelled = nullptr);
     void                setValue(const std::string &keypath, LOTVariant &value);
+    MemoryStats         memoryStats() const;
+    // drops the decoded images, see model::Asset::releaseImage().
+    void                releaseImages();
+    void                setBandCount(size_t count) { mBandCount = count; }
+    size_t              bandCount() const { return mBandCount; }
+    void                setPartialRedraw(bool enable) { mPartialRedraw = enable; }
+    bool                partialRedraw() const { return mPartialRedraw; }
+    // area of the surface that changed with the last render() call.
+    VRect               damage() const { return mDamage; }
+    // the next render() redraws and reports the whole surface.
+    void                invalidateDamage() { mLastSurface = rlottie::Surface(); }
+
+private:
+    void renderBand(const VRect &region, const VRect &band,
+                    SurfaceCache &cache);
+    void updateDamage(const rlottie::Surface &surface, const VRect &region);
 
 private:
     SurfaceCache                        mSurfaceCache;
+    std::vector<SurfaceCache>           mBandCaches;
     VBitmap                             mSurface;
     VMatrix                             mScaleMatrix;
     VSize                               mViewSize;
+    VRect                               mDamage;
+    rlottie::Surface                    mLastSurface;
     std::shared_ptr<model::Composition> mModel;
     Layer *                             mRootLayer{nullptr};
     VArenaAlloc                         mAllocator{2048};
     int                                 mCurFrameNo;
+    size_t                              mBandCount{1};
+    bool                                mPartialRedraw{false};
     bool                                mKeepAspectRatio{true};
     bool                                mHasDynamicValue{false};
 };
@@ -227,6 +235,9 @@ public:
     virtual DrawableList renderList() { return {}; }
     virtual void         render(VPainter *painter, const VRle &mask,
                                 const VRle &matteRle, SurfaceCache &cache);
+    // adds the area changed since the last call to damage and returns the
+    // area covered by the layer in the current frame.
+    virtual VRect        collectDamage(VRect &damage);
     bool                 hasMatte()
     {
         if (mLayerData->mMatteType == model::MatteType::None) return false;
@@ -242,6 +253,8 @@ public:
     const char *                 name() const { return mLayerData->name(); }
     virtual bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
                                 LOTVariant &value);
+    virtual void memoryUsage(MemoryStats &stats) const;
+    virtual void releaseImages() {}
 
 protected:
     virtual void   preprocessStage(const VRect &clip) = 0;
@@ -265,7 +278,9 @@ protected:
     float                      mCombinedAlpha{0.0};
     int                        mFrameNo{-1};
     DirtyFlag                  mDirtyFlag{DirtyFlagBit::All};
+    VRect                      mDrawnRect;
     bool                       mComplexContent{false};
+    bool                       mContentChanged{true};
     std::unique_ptr<CApiData>  mCApiData;
 };
 
@@ -275,9 +290,12 @@ public:
 
     void render(VPainter *painter, const VRle &mask, const VRle &matteRle,
                 SurfaceCache &cache) final;
+    VRect collectDamage(VRect &damage) final;
     void buildLayerNode() final;
     bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
                         LOTVariant &value) override;
+    void memoryUsage(MemoryStats &stats) const final;
+    void releaseImages() final;
 
 protected:
     void preprocessStage(const VRect &clip) final;
@@ -300,6 +318,7 @@ public:
     explicit SolidLayer(model::Layer *layerData);
     void         buildLayerNode() final;
     DrawableList renderList() final;
+    void         memoryUsage(MemoryStats &stats) const final;
 
 protected:
     void preprocessStage(const VRect &clip) final;
@@ -322,12 +341,14 @@ public:
                                 LOTVariant &value) override;
     void         render(VPainter *painter, const VRle &mask, const VRle &matteRle,
                         SurfaceCache &cache) final;
+    void         memoryUsage(MemoryStats &stats) const final;
 
 protected:
     void                     preprocessStage(const VRect &clip) final;
     void                     updateContent() final;
     std::vector<VDrawable *> mDrawableList;
     Group *                  mRoot{nullptr};
+    bool                     mDrawableListDirty{true};
 };
 
 class NullLayer final : public Layer {
@@ -344,12 +365,22 @@ public:
     explicit ImageLayer(model::Layer *layerData);
     void         buildLayerNode() final;
     DrawableList renderList() final;
+    void         memoryUsage(MemoryStats &stats) const final;
+    void         releaseImages() final
+    {
+        mTexture.mBitmap = VBitmap();
+        mImage.reset();
+    }
+    // fetches the image of the asset, decoding it on first use.
+    void         loadImage();
 
 protected:
     void preprocessStage(const VRect &clip) final;
     void updateContent() final;
 private:
     Drawable   mRenderNode;
+    // keeps the pixels of the asset image the texture refers to.
+    std::shared_ptr<const VBitmap> mImage;
     VTexture   mTexture;
     VPath      mPath;
     VDrawable *mDrawableList{nullptr};  // to work with the Span api
@@ -369,6 +400,7 @@ public:
     void         buildLayerNode() final;
     bool         resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
                                 LOTVariant &value) override;
+    void         memoryUsage(MemoryStats &stats) const final;
 
 protected:
     void                  preprocessStage(const VRect &clip) final;
@@ -378,6 +410,7 @@ protected:
     std::vector<std::unique_ptr<Drawable>> mRenderNode;
     std::vector<VDrawable *>               mDrawableList;
     std::vector<CharPath>                  mCharPathList;
+    bool                                   mDrawableListDirty{true};
 
 
     void updateTextPath(int frameNo)
@@ -452,6 +485,7 @@ public:
     {
         return false;
     }
+    virtual void memoryUsage(MemoryStats &) const {}
     virtual Object::Type type() const { return Object::Type::Unknown; }
 };
 
@@ -476,6 +510,7 @@ public:
     }
     bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
                         LOTVariant &value) override;
+    void memoryUsage(MemoryStats &stats) const override;
 
 protected:
     std::vector<Object *> mContents;
@@ -595,6 +630,7 @@ public:
                 const DirtyFlag &flag) override;
     void renderList(std::vector<VDrawable *> &list) final;
     Object::Type type() const final { return Object::Type::Paint; }
+    void memoryUsage(MemoryStats &stats) const final;
 
 protected:
     virtual bool updateContent(int frameNo, const VMatrix &matrix,
@@ -29,6 +29,13 @@ renderer::CApiData::CApiData()
     mLayer.keypath = nullptr;
 }
 
+size_t renderer::CApiData::memoryUsage() const
+{
+    return sizeof(*this) + mMasks.capacity() * sizeof(LOTMask) +
+           mLayers.capacity() * sizeof(LOTLayerNode *) +
+           mCNodeList.capacity() * sizeof(LOTNode *);
+}
+
 void renderer::Composition::buildRenderTree()
 {
     mRootLayer->buildLayerNode();
@@ -183,6 +190,7 @@ void renderer::SolidLayer::buildLayerNode()
 void renderer::ImageLayer::buildLayerNode()
 {
     renderer::Layer::buildLayerNode();
+    loadImage();
 
     auto renderlist = renderList();
 
@@ -20,6 +20,7 @@
  * SOFTWARE.
  */
 
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <sstream>
@@ -30,9 +31,18 @@ using namespace rlottie::internal;
 
 #ifdef LOTTIE_CACHE_SUPPORT
 
+#include <future>
+#include <list>
 #include <mutex>
 #include <unordered_map>
 
+/*
+ * LRU cache of the parsed models. A lookup moves the entry to the front,
+ * the least recently used entries are evicted once the cache holds more
+ * than the entry count or the byte budget.
+ * Concurrent loads of a key that is not cached yet are coalesced, the
+ * first caller parses the resource and the others wait for its result.
+ */
 class ModelCache {
 public:
     static ModelCache &instance()
@@ -47,20 +57,75 @@ public:
         if (!mcacheSize) return nullptr;
 
         auto search = mHash.find(key);
-
-        return (search != mHash.end()) ? search->second : nullptr;
+        if (search == mHash.end()) {
+            mStats.misses++;
+            return nullptr;
+        }
+
+        mStats.hits++;
+        mEntries.splice(mEntries.begin(), mEntries, search->second);
+        return search->second->value;
     }
+    template <typename Parse>
+    std::shared_ptr<model::Composition> load(const std::string &key,
+                                             Parse &&          parse)
+    {
+        std::shared_ptr<std::promise<Model>> sender;
+        std::shared_future<Model>            pending;
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+
+            auto search = mHash.find(key);
+            auto inflight = mPending.find(key);
+            if (!mcacheSize) {
+                // caching disabled, every caller parses its own copy.
+            } else if (search != mHash.end()) {
+                mStats.hits++;
+                mEntries.splice(mEntries.begin(), mEntries, search->second);
+                return search->second->value;
+            } else if (inflight != mPending.end()) {
+                mStats.coalesced++;
+                pending = inflight->second;
+            } else {
+                mStats.misses++;
+                sender = std::make_shared<std::promise<Model>>();
+                mPending[key] = sender->get_future().share();
+            }
+        }
+        // the parse is already running on another thread.
+        if (pending.valid()) return pending.get();
+
+        auto obj = parse();
+        if (!sender) return obj;
+
+        if (obj) add(key, obj);
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            mPending.erase(key);
+        }
+        sender->set_value(obj);
+        return obj;
+    }
+
     void add(const std::string &key, std::shared_ptr<model::Composition> value)
     {
+        auto bytes = value->memoryUsage();
+
         std::lock_guard<std::mutex> guard(mMutex);
 
         if (!mcacheSize) return;
 
-        //@TODO just remove the 1st element
-        // not the best of LRU logic
-        if (mcacheSize == mHash.size()) mHash.erase(mHash.cbegin());
+        auto search = mHash.find(key);
+        if (search != mHash.end()) remove(search->second);
+
+        // would evict the whole cache and still not fit.
+        if (mBudget && bytes > mBudget) return;
 
-        mHash[key] = std::move(value);
+        mEntries.push_front({key, std::move(value), bytes});
+        mHash[key] = mEntries.begin();
+        mStats.bytes += bytes;
+
+        evict();
     }
 
     void configureCacheSize(size_t cacheSize)
@@ -68,15 +133,73 @@ public:
         std::lock_guard<std::mutex> guard(mMutex);
         mcacheSize = cacheSize;
 
-        if (!mcacheSize) mHash.clear();
+        if (!mcacheSize) {
+            mHash.clear();
+            mEntries.clear();
+            mStats.bytes = 0;
+        }
+        evict();
+    }
+
+    void configureBudget(size_t bytes)
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mBudget = bytes;
+        evict();
+    }
+
+    model::CacheStats stats()
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        auto stats = mStats;
+        stats.entries = mEntries.size();
+        return stats;
+    }
+
+    std::vector<std::shared_ptr<model::Composition>> models()
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        std::vector<std::shared_ptr<model::Composition>> result;
+        result.reserve(mEntries.size());
+        for (const auto &e : mEntries) result.push_back(e.value);
+        return result;
     }
 
 private:
+    using Model = std::shared_ptr<model::Composition>;
+
+    struct Entry {
+        std::string                         key;
+        std::shared_ptr<model::Composition> value;
+        size_t                              bytes;
+    };
+
     ModelCache() = default;
 
-    std::unordered_map<std::string, std::shared_ptr<model::Composition>> mHash;
-    std::mutex                                                           mMutex;
+    void remove(std::list<Entry>::iterator it)
+    {
+        mStats.bytes -= it->bytes;
+        mHash.erase(it->key);
+        mEntries.erase(it);
+    }
+
+    void evict()
+    {
+        while (!mEntries.empty() &&
+               (mEntries.size() > mcacheSize ||
+                (mBudget && mStats.bytes > mBudget))) {
+            remove(std::prev(mEntries.end()));
+            mStats.evictions++;
+        }
+    }
+
+    std::list<Entry>                                              mEntries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> mHash;
+    std::unordered_map<std::string, std::shared_future<Model>>   mPending;
+    std::mutex                                                    mMutex;
+    model::CacheStats                                             mStats;
     size_t mcacheSize{10};
+    size_t mBudget{0};
 };
 
 #else
@@ -92,8 +215,76 @@ public:
     {
         return nullptr;
     }
+    template <typename Parse>
+    std::shared_ptr<model::Composition> load(const std::string &, Parse &&parse)
+    {
+        return parse();
+    }
     void add(const std::string &, std::shared_ptr<model::Composition>) {}
     void configureCacheSize(size_t) {}
+    void configureBudget(size_t) {}
+    model::CacheStats stats() { return {}; }
+    std::vector<std::shared_ptr<model::Composition>> models() { return {}; }
+};
+
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Maps the file with MAP_PRIVATE so that the in situ parser can write into
+ * the buffer without touching the file, and without copying it up front.
+ * The parser stops at the null terminator, the kernel fills the end of the
+ * last page with zeros, so the file is only mapped if that page has room
+ * for it.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat info;
+        auto pageSize = sysconf(_SC_PAGESIZE);
+        if (!fstat(fd, &info) && S_ISREG(info.st_mode) && info.st_size > 0 &&
+            pageSize > 0 && info.st_size % pageSize) {
+            auto data = mmap(nullptr, size_t(info.st_size),
+                             PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                mData = static_cast<char *>(data);
+                mSize = size_t(info.st_size);
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile()
+    {
+        if (mData) munmap(mData, mSize);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    char * data() const { return mData; }
+    size_t size() const { return mSize; }
+
+private:
+    char * mData{nullptr};
+    size_t mSize{0};
+};
+
+#else
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &) {}
+    char * data() const { return nullptr; }
+    size_t size() const { return 0; }
 };
 
 #endif
@@ -113,63 +304,182 @@ void model::configureModelCacheSize(size_t cacheSize)
     ModelCache::instance().configureCacheSize(cacheSize);
 }
 
-std::shared_ptr<model::Composition> model::loadFromFile(const std::string &path,
-                                                        bool cachePolicy)
+void model::configureModelCacheBudget(size_t bytes)
 {
-    if (cachePolicy) {
-        auto obj = ModelCache::instance().find(path);
-        if (obj) return obj;
-    }
+    ModelCache::instance().configureBudget(bytes);
+}
+
+model::CacheStats model::modelCacheStats()
+{
+    return ModelCache::instance().stats();
+}
+
+std::vector<std::shared_ptr<model::Composition>> model::cachedModels()
+{
+    return ModelCache::instance().models();
+}
+
+static std::shared_ptr<model::Composition> parseFile(const std::string &path)
+{
+    MappedFile file(path);
+    if (file.data())
+        return model::parse(file.data(), file.size(), dirname(path));
 
     std::ifstream f;
-    f.open(path);
+    f.open(path, std::ios::binary);
 
     if (!f.is_open()) {
         vCritical << "failed to open file = " << path.c_str();
         return {};
-    } else {
-        std::string content;
-        f.seekg(0, std::ios::end);
-        auto fsize = f.tellg();
+    }
 
-        //read the given file
-        content.reserve(fsize);
-        f.seekg(0, std::ios::beg);
-        content.assign((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    // parse while reading instead of loading the whole file first.
+    return model::parse(
+        [&f](char *buffer, size_t size) {
+            f.read(buffer, std::streamsize(size));
+            return size_t(f.gcount());
+        },
+        dirname(path));
+}
 
-        f.close();
+/*
+ * a model without metadata is cached under its own key, so a load asking
+ * for the full model never gets it.
+ */
+static std::string leanKey(std::string key, bool dropMetadata)
+{
+    if (dropMetadata) key.append("\0lean", 5);
+    return key;
+}
 
-        if (fsize == 0) return {};
+static std::shared_ptr<model::Composition>
+lean(std::shared_ptr<model::Composition> comp, bool dropMetadata)
+{
+    if (comp && dropMetadata) comp->dropMetadata();
+    return comp;
+}
 
-        auto obj = internal::model::parse(const_cast<char *>(content.c_str()), fsize,
-                                          dirname(path));
+std::shared_ptr<model::Composition> model::loadFromFile(const std::string &path,
+                                                        bool cachePolicy,
+                                                        bool dropMetadata)
+{
+    if (!cachePolicy) return lean(parseFile(path), dropMetadata);
 
-        if (obj && cachePolicy) ModelCache::instance().add(path, obj);
+    return ModelCache::instance().load(leanKey(path, dropMetadata), [&] {
+        return lean(parseFile(path), dropMetadata);
+    });
+}
 
-        return obj;
+/*
+ * 64 bit MurmurHash2 of the data, consumes 8 bytes per round so hashing
+ * is cheap compared to parsing even for large payloads.
+ */
+static uint64_t contentHash(const char *data, size_t size)
+{
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int      r = 47;
+
+    uint64_t h = 0x8445d61a4e774912ULL ^ (size * m);
+
+    const char *end = data + (size & ~size_t(7));
+    for (; data != end; data += 8) {
+        uint64_t k;
+        memcpy(&k, data, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    switch (size & 7) {
+    case 7: h ^= uint64_t(uint8_t(data[6])) << 48; // fall through
+    case 6: h ^= uint64_t(uint8_t(data[5])) << 40; // fall through
+    case 5: h ^= uint64_t(uint8_t(data[4])) << 32; // fall through
+    case 4: h ^= uint64_t(uint8_t(data[3])) << 24; // fall through
+    case 3: h ^= uint64_t(uint8_t(data[2])) << 16; // fall through
+    case 2: h ^= uint64_t(uint8_t(data[1])) << 8;  // fall through
+    case 1:
+        h ^= uint64_t(uint8_t(data[0]));
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+/*
+ * cache key of data loaded without a caller supplied key. The leading
+ * '\0' keeps it apart from file paths and user keys, the resource path
+ * is part of the key as it decides which external images get loaded.
+ */
+static std::string contentKey(const std::string &data,
+                              const std::string &resourcePath,
+                              const std::string &filterKey = {})
+{
+    char hash[40];
+    snprintf(hash, sizeof(hash), "%016llx:%zu",
+             static_cast<unsigned long long>(contentHash(data.data(), data.size())),
+             data.size());
+
+    std::string key(1, '\0');
+    key += hash;
+    key += ':';
+    key += resourcePath;
+    if (!filterKey.empty()) {
+        key += '\0';
+        key += filterKey;
     }
+    return key;
 }
 
 std::shared_ptr<model::Composition> model::loadFromData(
     std::string jsonData, const std::string &key, std::string resourcePath,
-    bool cachePolicy)
+    bool cachePolicy, bool dropMetadata)
 {
-    if (cachePolicy) {
-        auto obj = ModelCache::instance().find(key);
-        if (obj) return obj;
-    }
+    auto parse = [&] {
+        return lean(internal::model::parse(const_cast<char *>(jsonData.c_str()),
+                                           jsonData.size(),
+                                           std::move(resourcePath)),
+                    dropMetadata);
+    };
 
-    auto obj = internal::model::parse(const_cast<char *>(jsonData.c_str()), jsonData.size(),
-                                      std::move(resourcePath));
+    if (!cachePolicy) return parse();
 
-    if (obj && cachePolicy) ModelCache::instance().add(key, obj);
+    auto cacheKey = key.empty() ? contentKey(jsonData, resourcePath) : key;
 
-    return obj;
+    return ModelCache::instance().load(leanKey(std::move(cacheKey), dropMetadata),
+                                       parse);
 }
 
 std::shared_ptr<model::Composition> model::loadFromData(
-    std::string jsonData, std::string resourcePath, model::ColorFilter filter)
+    std::string jsonData, std::string resourcePath, model::ColorFilter filter,
+    const std::string &filterKey)
+{
+    auto parse = [&] {
+        return internal::model::parse(const_cast<char *>(jsonData.c_str()),
+                                      jsonData.size(), std::move(resourcePath),
+                                      std::move(filter));
+    };
+
+    // a filter without identity can't be told apart from any other one.
+    if (filterKey.empty()) return parse();
+
+    return ModelCache::instance().load(
+        contentKey(jsonData, resourcePath, filterKey), parse);
+}
+
+std::shared_ptr<model::Composition> model::loadFromStream(
+    model::ChunkReader reader, const std::string &key, std::string resourcePath,
+    bool cachePolicy)
 {
-    return internal::model::parse(const_cast<char *>(jsonData.c_str()), jsonData.size(),
-                                  std::move(resourcePath), std::move(filter));
+    // streamed data can't be hashed before parsing, only cache by key.
+    if (key.empty() || !cachePolicy)
+        return internal::model::parse(std::move(reader), std::move(resourcePath));
+
+    return ModelCache::instance().load(key, [&] {
+        return internal::model::parse(std::move(reader), std::move(resourcePath));
+    });
 }
@@ -24,6 +24,7 @@
 #include <cassert>
 #include <iterator>
 #include <stack>
+#include <unordered_set>
 #include "vimageloader.h"
 #include "vline.h"
 
@@ -91,6 +92,118 @@ public:
     }
 };
 
+/*
+ * Folds the static content of the shape layers at load time, so the
+ * renderer walks a smaller tree every frame.
+ * A group that holds only static paths and has no transform or a static
+ * one is replaced by its paths, with the group matrix applied to the path
+ * points. Such a group holds no paint, so its opacity and its matrix are
+ * used by nothing else. Named groups are kept as a keypath may change
+ * their transform, they are folded once the names are dropped.
+ * Consecutive static paths of a group are painted by the same paints, so
+ * they are merged into the first one. Layers with trim paths keep them
+ * apart as trimming works on the individual paths.
+ * Groups left without children are dropped.
+ * The layers of a precomp asset are shared by the layers referencing it,
+ * they are folded once.
+ */
+class LottieStaticContentFolder {
+    std::unordered_set<model::Layer *> mVisited;
+
+public:
+    void visitLayer(model::Layer *layer)
+    {
+        if (!mVisited.insert(layer).second) return;
+        visitChildren(layer, !layer->hasPathOperator());
+    }
+
+private:
+    static bool isStaticPath(const model::Object *obj)
+    {
+        return obj->type() == model::Object::Type::Path &&
+               static_cast<const model::Path *>(obj)->mShape.isStatic();
+    }
+    static bool foldable(const model::Group *group)
+    {
+        auto name = group->name();
+        if (name && name[0]) return false;
+        if (group->mTransform && !group->mTransform->isStatic()) return false;
+        return std::all_of(group->mChildren.cbegin(), group->mChildren.cend(),
+                           isStaticPath);
+    }
+    static void transform(model::PathData &path, const VMatrix &m)
+    {
+        for (auto &e : path.mPoints) e = m.map(e);
+    }
+    static void transform(model::Path *path, const VMatrix &m)
+    {
+        transform(path->mShape.value(), m);
+        for (auto &e : path->mMerged) transform(e, m);
+    }
+    static void merge(model::Path *to, model::Path *from)
+    {
+        to->mMerged.push_back(std::move(from->mShape.value()));
+        std::move(from->mMerged.begin(), from->mMerged.end(),
+                  back_inserter(to->mMerged));
+    }
+
+    void visitChildren(model::Group *obj, bool mergePaths)
+    {
+        std::vector<model::Object *> children;
+        children.reserve(obj->mChildren.size());
+
+        for (const auto &child : obj->mChildren) {
+            switch (child->type()) {
+            case model::Object::Type::Layer: {
+                visitLayer(static_cast<model::Layer *>(child));
+                break;
+            }
+            case model::Object::Type::Repeater: {
+                auto content = static_cast<model::Repeater *>(child)->content();
+                if (content) visitChildren(content, mergePaths);
+                break;
+            }
+            case model::Object::Type::Group: {
+                auto group = static_cast<model::Group *>(child);
+                visitChildren(group, mergePaths);
+                if (group->mChildren.empty()) continue;
+                if (!foldable(group)) break;
+
+                if (group->mTransform) {
+                    auto m = group->mTransform->matrix(0);
+                    if (!m.isIdentity()) {
+                        for (auto &e : group->mChildren)
+                            transform(static_cast<model::Path *>(e), m);
+                    }
+                }
+                children.insert(children.end(), group->mChildren.begin(),
+                                group->mChildren.end());
+                continue;
+            }
+            default:
+                break;
+            }
+            children.push_back(child);
+        }
+
+        if (mergePaths) {
+            auto last = children.begin();
+            for (auto it = children.begin(); it != children.end(); ++it) {
+                if (last != children.begin() && isStaticPath(*it) &&
+                    isStaticPath(*(last - 1))) {
+                    merge(static_cast<model::Path *>(*(last - 1)),
+                          static_cast<model::Path *>(*it));
+                    continue;
+                }
+                *last++ = *it;
+            }
+            children.erase(last, children.end());
+        }
+
+        obj->mChildren = std::move(children);
+    }
+};
+
 class LottieUpdateStatVisitor {
     model::Composition::Stats *stat;
 
@@ -146,12 +259,387 @@ public:
     }
 };
 
+/*
+ * Clears the names of the objects, and of the text animators, and notes
+ * what the layers refer to: the assets by their id and the fonts if there
+ * is a text layer. Layers of a precomp asset are shared by the layers
+ * referencing it, so they are visited once.
+ */
+class LottieMetadataStripper {
+    std::unordered_set<model::Object *> mVisited;
+
+public:
+    std::unordered_set<std::string> mUsedAssets;
+    bool                            mHasText{false};
+
+    void visitLayer(model::Layer *layer)
+    {
+        if (layer->mLayerType == model::Layer::Type::Text) mHasText = true;
+        if (layer->mExtra) {
+            auto extra = layer->mExtra.get();
+            if (!extra->mPreCompRefId.empty())
+                mUsedAssets.insert(extra->mPreCompRefId);
+            if (extra->mTextLayerData) {
+                for (auto &e : extra->mTextLayerData->mTextAnimator)
+                    std::string().swap(e.mName);
+            }
+        }
+        visitGroup(layer);
+    }
+    void visitGroup(model::Group *obj)
+    {
+        if (obj->mTransform) obj->mTransform->clearName();
+        for (const auto &child : obj->mChildren) {
+            if (child) visit(child);
+        }
+    }
+    void visit(model::Object *obj)
+    {
+        if (!mVisited.insert(obj).second) return;
+
+        obj->clearName();
+        switch (obj->type()) {
+        case model::Object::Type::Layer:
+            visitLayer(static_cast<model::Layer *>(obj));
+            break;
+        case model::Object::Type::Group:
+            visitGroup(static_cast<model::Group *>(obj));
+            break;
+        case model::Object::Type::Repeater: {
+            auto content = static_cast<model::Repeater *>(obj)->content();
+            if (content) visit(content);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+};
+
+/*
+ * Sums the heap memory held by the model objects. The objects themselves
+ * live in the composition arena, which is accounted as a whole. Layers of
+ * a precomp asset are shared by every layer referencing it, so they are
+ * counted once. Keyframes and path points are reported apart from the rest
+ * as they make up most of a typical model, the part of them living in the
+ * arena is taken out of the arena figure.
+ */
+class LottieMemoryVisitor {
+    std::unordered_set<const model::Object *> mVisited;
+    // consecutive keyframes share the points of their common value.
+    std::unordered_set<const VPointF *>        mPoints;
+
+public:
+    model::Composition::MemoryStats mStats;
+    size_t                          mArenaHeld{0};
+
+    template <typename T>
+    void addValue(const T &value, size_t &bytes)
+    {
+        bytes += model::valueHeapSize(value);
+    }
+    void addValue(const model::PathData &value, size_t &)
+    {
+        if (value.mPoints.empty() ||
+            !mPoints.insert(value.mPoints.data()).second)
+            return;
+        auto bytes = value.mPoints.size() * sizeof(VPointF);
+        mStats.paths += bytes;
+        mArenaHeld += bytes;
+    }
+    template <typename T, typename Tag>
+    void add(const model::Property<T, Tag> &prop)
+    {
+        if (prop.isStatic()) {
+            addValue(prop.value(), mStats.other);
+            return;
+        }
+        const auto &animation = prop.animation();
+        using Frames = model::KeyFrames<T, Tag>;
+        auto frames = animation.size() * (sizeof(typename Frames::Frame) +
+                                          sizeof(animation.values_[0]));
+        mStats.keyframes += sizeof(animation) + frames;
+        mArenaHeld += frames;
+        for (const auto &e : animation.values_) {
+            addValue(e.start_, mStats.keyframes);
+            addValue(e.end_, mStats.keyframes);
+        }
+    }
+    void add(const std::string &str)
+    {
+        // short strings are stored inline.
+        if (str.capacity() >= sizeof(std::string))
+            mStats.other += str.capacity() + 1;
+    }
+    void add(const model::Dash &dash)
+    {
+        mStats.other += dash.mData.capacity() * sizeof(model::Property<float>);
+        for (const auto &e : dash.mData) add(e);
+    }
+    void add(const model::Gradient &obj)
+    {
+        add(obj.mStartPoint);
+        add(obj.mEndPoint);
+        add(obj.mHighlightLength);
+        add(obj.mHighlightAngle);
+        add(obj.mOpacity);
+        add(obj.mGradient);
+    }
+    void add(const model::Transform *obj)
+    {
+        auto data = obj->data();
+        if (!data) return;
+        add(data->mRotation);
+        add(data->mScale);
+        add(data->mPosition);
+        add(data->mAnchor);
+        add(data->mOpacity);
+        if (data->mExtra) {
+            mStats.other += sizeof(model::Transform::Data::Extra);
+            add(data->mExtra->m3DRx);
+            add(data->mExtra->m3DRy);
+            add(data->mExtra->m3DRz);
+            add(data->mExtra->mSeparateX);
+            add(data->mExtra->mSeparateY);
+        }
+    }
+    void add(const model::TextLayerData &text)
+    {
+        mStats.other += sizeof(model::TextLayerData);
+        mStats.other += text.mTextDocument.capacity() * sizeof(model::TextDocument);
+        for (const auto &e : text.mTextDocument) {
+            add(e.mFont);
+            add(e.mText.getUtf8Text());
+            mStats.other += (e.mText.end() - e.mText.begin()) * sizeof(uint32_t);
+        }
+        mStats.other += text.mTextAnimator.capacity() * sizeof(model::TextAnimator);
+        for (const auto &e : text.mTextAnimator) {
+            add(e.mName);
+            add(e.mRangeStart);
+            add(e.mRangeEnd);
+            mStats.other += e.mAnimatedProperties.capacity() *
+                      sizeof(model::PropertyText);
+        }
+    }
+    void visitLayer(const model::Layer *layer)
+    {
+        if (layer->mExtra) {
+            auto extra = layer->mExtra.get();
+            mStats.other += sizeof(model::Layer::Extra);
+            add(extra->mPreCompRefId);
+            add(extra->mTimeRemap);
+            mStats.other += extra->mMasks.capacity() * sizeof(model::Mask *);
+            for (const auto &e : extra->mMasks) {
+                add(e->mShape);
+                add(e->mOpacity);
+            }
+            if (extra->mTextLayerData) add(*extra->mTextLayerData);
+        }
+        visitGroup(layer);
+    }
+    void visitGroup(const model::Group *obj)
+    {
+        mStats.other += obj->mChildren.capacity() * sizeof(model::Object *);
+        if (obj->mTransform) add(obj->mTransform);
+        for (const auto &child : obj->mChildren) {
+            if (child) visit(child);
+        }
+    }
+    void visit(const model::Object *obj)
+    {
+        if (!mVisited.insert(obj).second) return;
+
+        auto name = obj->name();
+        if (name) {
+            auto len = strlen(name);
+            // names longer than the inline buffer are duplicated.
+            if (len >= 14) mStats.other += len + 1;
+        }
+
+        switch (obj->type()) {
+        case model::Object::Type::Layer:
+            visitLayer(static_cast<const model::Layer *>(obj));
+            break;
+        case model::Object::Type::Group:
+            visitGroup(static_cast<const model::Group *>(obj));
+            break;
+        case model::Object::Type::Fill: {
+            auto fill = static_cast<const model::Fill *>(obj);
+            add(fill->mColor);
+            add(fill->mOpacity);
+            break;
+        }
+        case model::Object::Type::Stroke: {
+            auto stroke = static_cast<const model::Stroke *>(obj);
+            add(stroke->mColor);
+            add(stroke->mOpacity);
+            add(stroke->mWidth);
+            add(stroke->mDash);
+            break;
+        }
+        case model::Object::Type::GFill:
+            add(*static_cast<const model::Gradient *>(obj));
+            break;
+        case model::Object::Type::GStroke: {
+            auto stroke = static_cast<const model::GradientStroke *>(obj);
+            add(*stroke);
+            add(stroke->mWidth);
+            add(stroke->mDash);
+            break;
+        }
+        case model::Object::Type::Rect: {
+            auto rect = static_cast<const model::Rect *>(obj);
+            add(rect->mPos);
+            add(rect->mSize);
+            add(rect->mRound);
+            break;
+        }
+        case model::Object::Type::Ellipse: {
+            auto ellipse = static_cast<const model::Ellipse *>(obj);
+            add(ellipse->mPos);
+            add(ellipse->mSize);
+            break;
+        }
+        case model::Object::Type::Path: {
+            auto path = static_cast<const model::Path *>(obj);
+            add(path->mShape);
+            mStats.other += path->mMerged.capacity() * sizeof(model::PathData);
+            for (const auto &e : path->mMerged) addValue(e, mStats.other);
+            break;
+        }
+        case model::Object::Type::Polystar: {
+            auto star = static_cast<const model::Polystar *>(obj);
+            add(star->mPos);
+            add(star->mPointCount);
+            add(star->mInnerRadius);
+            add(star->mOuterRadius);
+            add(star->mInnerRoundness);
+            add(star->mOuterRoundness);
+            add(star->mRotation);
+            break;
+        }
+        case model::Object::Type::Trim: {
+            auto trim = static_cast<const model::Trim *>(obj);
+            add(trim->mStart);
+            add(trim->mEnd);
+            add(trim->mOffset);
+            break;
+        }
+        case model::Object::Type::Repeater: {
+            auto repeater = static_cast<const model::Repeater *>(obj);
+            add(repeater->mTransform.mRotation);
+            add(repeater->mTransform.mScale);
+            add(repeater->mTransform.mPosition);
+            add(repeater->mTransform.mAnchor);
+            add(repeater->mTransform.mStartOpacity);
+            add(repeater->mTransform.mEndOpacity);
+            add(repeater->mCopies);
+            add(repeater->mOffset);
+            if (repeater->content()) visit(repeater->content());
+            break;
+        }
+        case model::Object::Type::RoundedCorner:
+            add(static_cast<const model::RoundedCorner *>(obj)->mRadius);
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+model::Composition::MemoryStats model::Composition::memoryStats() const
+{
+    LottieMemoryVisitor visitor;
+    if (mRootLayer) visitor.visit(mRootLayer);
+
+    auto &stats = visitor.mStats;
+    visitor.add(mVersion);
+    auto arena = mArenaAlloc.allocatedBytes();
+    stats.arena += arena > visitor.mArenaHeld ? arena - visitor.mArenaHeld : 0;
+    stats.other += sizeof(*this);
+    stats.other += mIdenticalFrames.capacity() * sizeof(mIdenticalFrames[0]);
+    stats.other += mMarkers.capacity() * sizeof(Marker);
+    for (const auto &e : mMarkers) visitor.add(std::get<0>(e));
+
+    for (const auto &e : mAssets) {
+        // hash node, key and value.
+        stats.other += sizeof(e) + sizeof(void *);
+        visitor.add(e.first);
+        auto asset = e.second;
+        visitor.add(asset->mRefId);
+        stats.other += asset->mLayers.capacity() * sizeof(Object *);
+        for (const auto &layer : asset->mLayers) visitor.visit(layer);
+        stats.other += asset->encodedImageMemory();
+        stats.images += asset->decodedImageMemory();
+    }
+
+    // strings of the font db go to fonts as well.
+    auto other = stats.other;
+    stats.other += mFontDB.mFonts.capacity() * sizeof(Fonts);
+    for (const auto &e : mFontDB.mFonts) {
+        visitor.add(e.mFontName);
+        visitor.add(e.mFontFamily);
+        visitor.add(e.mFontStyle);
+    }
+    stats.other += mFontDB.mChars.capacity() * sizeof(Chars);
+    for (const auto &e : mFontDB.mChars) {
+        visitor.add(e.mStyle);
+        visitor.add(e.mFontFamily);
+        stats.other += e.mOutline.points().capacity() * sizeof(VPointF) +
+                       e.mOutline.elements().capacity() * sizeof(VPath::Element);
+    }
+    stats.fonts += stats.other - other;
+    stats.other = other;
+
+    return stats;
+}
+
+size_t model::Composition::memoryUsage() const
+{
+    return memoryStats().total();
+}
+
 void model::Composition::processRepeaterObjects()
 {
     LottieRepeaterProcesser visitor;
     visitor.visit(mRootLayer);
 }
 
+void model::Composition::foldStaticContent()
+{
+    LottieStaticContentFolder visitor;
+    visitor.visitLayer(mRootLayer);
+}
+
+/*
+ * Renders the same, but keypaths naming objects match nothing, the markers
+ * are gone and the layers have no names. The assets no layer refers to are
+ * dropped with their image data, the fonts are dropped if no layer draws
+ * text. The static groups kept for their names get folded.
+ */
+void model::Composition::dropMetadata()
+{
+    LottieMetadataStripper visitor;
+    visitor.visit(mRootLayer);
+
+    auto used = std::move(visitor.mUsedAssets);
+    for (auto it = mAssets.begin(); it != mAssets.end();) {
+        if (used.count(it->first)) {
+            ++it;
+            continue;
+        }
+        // the layers stay in the arena, only their names can go.
+        for (const auto &layer : it->second->mLayers) visitor.visit(layer);
+        it->second->release();
+        it = mAssets.erase(it);
+    }
+
+    std::vector<Marker>().swap(mMarkers);
+    if (!visitor.mHasText) mFontDB = FontDB();
+
+    foldStaticContent();
+}
+
 void model::Composition::updateStats()
 {
     LottieUpdateStatVisitor visitor(&mStats);
@@ -337,15 +825,76 @@ void model::Gradient::update(std::unique_ptr<VGradient> &grad, int frameNo)
     }
 }
 
+std::shared_ptr<const VBitmap> model::Asset::bitmap() const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    // a broken image is not decoded again on every frame.
+    if (mBitmap || mDecodeFailed) return mBitmap;
+
+    VBitmap bitmap;
+    if (!mImageData.empty()) {
+        bitmap = VImageLoader::instance().load(mImageData.c_str(),
+                                               mImageData.length());
+    } else if (!mImagePath.empty()) {
+        bitmap = VImageLoader::instance().load(mImagePath.c_str());
+    }
+    mDecodeFailed = !bitmap.valid();
+    if (!mDecodeFailed)
+        mBitmap = std::make_shared<const VBitmap>(std::move(bitmap));
+    return mBitmap;
+}
+
+void model::Asset::setBitmap(VBitmap bitmap)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    mBitmap.reset();
+    if (bitmap.valid())
+        mBitmap = std::make_shared<const VBitmap>(std::move(bitmap));
+}
+
 void model::Asset::loadImageData(std::string data)
 {
-    if (!data.empty())
-        mBitmap = VImageLoader::instance().load(data.c_str(), data.length());
+    mImageData = std::move(data);
 }
 
 void model::Asset::loadImagePath(std::string path)
 {
-    if (!path.empty()) mBitmap = VImageLoader::instance().load(path.c_str());
+    mImagePath = std::move(path);
+}
+
+void model::Asset::releaseImage()
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (mImageData.empty() && mImagePath.empty()) return;
+    mBitmap.reset();
+}
+
+size_t model::Asset::encodedImageMemory() const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mImageData.capacity() + mImagePath.capacity();
+}
+
+size_t model::Asset::decodedImageMemory() const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mBitmap ? mBitmap->stride() * mBitmap->height() : 0;
+}
+
+void model::Asset::release()
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    std::string().swap(mRefId);
+    std::vector<Object *>().swap(mLayers);
+    std::string().swap(mImageData);
+    std::string().swap(mImagePath);
+    mBitmap.reset();
+}
+
+void model::Composition::releaseImages() const
+{
+    for (const auto &e : mAssets) e.second->releaseImage();
 }
 
 std::vector<LayerInfo> model::Composition::layerInfoList() const
@@ -363,3 +912,19 @@ std::vector<LayerInfo> model::Composition::layerInfoList() const
 
     return result;
 }
+
+bool model::Composition::isFrameIdentical(int prevFrame, int curFrame) const
+{
+    if (prevFrame == curFrame) return true;
+
+    auto it = std::upper_bound(
+        mIdenticalFrames.begin(), mIdenticalFrames.end(), prevFrame,
+        [](int frameNo, const std::pair<int, int> &range) {
+            return frameNo < range.first;
+        });
+    if (it == mIdenticalFrames.begin()) return false;
+    --it;
+
+    return prevFrame <= it->second && curFrame >= it->first &&
+           curFrame <= it->second;
+}
@@ -24,10 +24,12 @@
 #define LOTModel_H
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include "varenaalloc.h"
@@ -55,6 +57,40 @@ inline T lerp(const T &start, const T &end, float t)
     return start + t * (end - start);
 }
 
+template <class T>
+class VSpan {
+public:
+    using reference = T &;
+    using pointer = T *;
+    using const_pointer = T const *;
+    using const_reference = T const &;
+    using index_type = size_t;
+
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+
+    VSpan() = default;
+    VSpan(pointer data, index_type size) : _data(data), _size(size) {}
+
+    constexpr pointer        data() const noexcept { return _data; }
+    constexpr index_type     size() const noexcept { return _size; }
+    constexpr bool           empty() const noexcept { return size() == 0; }
+    constexpr iterator       begin() const noexcept { return data(); }
+    constexpr iterator       end() const noexcept { return data() + size(); }
+    constexpr const_iterator cbegin() const noexcept { return data(); }
+    constexpr const_iterator cend() const noexcept { return data() + size(); }
+    constexpr reference      operator[](index_type idx) const
+    {
+        return *(data() + idx);
+    }
+    constexpr reference      front() const { return *data(); }
+    constexpr reference      back() const { return *(data() + size() - 1); }
+
+private:
+    pointer    _data{nullptr};
+    index_type _size{0};
+};
+
 namespace model {
 
 enum class MatteType : uint8_t { None = 0, Alpha = 1, AlphaInv, Luma, LumaInv };
@@ -112,9 +148,20 @@ inline bool operator==(const Color &c1, const Color &c2)
 }
 
 struct PathData {
-    std::vector<VPointF> mPoints;
-    bool                 mClosed = false; /* "c" */
-    void        reserve(size_t size) { mPoints.reserve(mPoints.size() + size); }
+    // the points live in the composition arena, see assign().
+    VSpan<VPointF> mPoints;
+    bool           mClosed = false; /* "c" */
+    void           assign(VArenaAlloc &allocator, const VPointF *points,
+                          size_t count)
+    {
+        if (!count) {
+            mPoints = {};
+            return;
+        }
+        auto data = allocator.makeArrayDefault<VPointF>(count);
+        std::copy(points, points + count, data);
+        mPoints = VSpan<VPointF>(data, count);
+    }
     static void lerp(const PathData &start, const PathData &end, float t,
                      VPath &result)
     {
@@ -145,7 +192,11 @@ struct PathData {
     void toPath(VPath &path) const
     {
         path.reset();
-
+        addTo(path);
+    }
+    // appends the contour to the path.
+    void addTo(VPath &path) const
+    {
         if (mPoints.empty()) return;
 
         auto size = mPoints.size();
@@ -163,6 +214,13 @@ struct PathData {
     }
 };
 
+// bytes a property value holds on the heap.
+template <typename T>
+inline size_t valueHeapSize(const T &)
+{
+    return 0;
+}
+
 template <typename T, typename Tag = void>
 struct Value {
     T     start_;
@@ -170,6 +228,7 @@ struct Value {
     T     at(float t) const { return lerp(start_, end_, t); }
     float angle(float) const { return 0; }
     void  cache() {}
+    void  setupTables(VArenaAlloc &) {}
 };
 
 struct Position;
@@ -198,6 +257,37 @@ struct Value<T, Position> {
         }
     }
 
+    /*
+     * arc length of the motion path at evenly spaced curve parameters, so
+     * the parameter at a length is a search and a lerp instead of
+     * bisecting the curve. Samples are about two pixels apart, the
+     * positions found stay within a tenth of a pixel of bisecting for
+     * paths up to a few thousand pixels long.
+     */
+    void setupTables(VArenaAlloc &allocator)
+    {
+        if (!hasTangent_) return;
+
+        auto samples = int(std::ceil(length_ / 2));
+        samples = std::max(8, std::min(samples, 256));
+        auto lengths = allocator.makeArrayDefault<float>(size_t(samples) + 1);
+
+        VBezier b = VBezier::fromPoints(start_, outTangent_, inTangent_, end_);
+        lengths[0] = 0;
+        for (int i = 0; i < samples; i++) {
+            lengths[i + 1] = lengths[i] + b.onInterval(float(i) / samples,
+                                                       float(i + 1) / samples)
+                                              .length();
+        }
+        // match the total length the progress is scaled with.
+        if (vIsZero(lengths[samples])) return;
+        auto scale = length_ / lengths[samples];
+        for (int i = 1; i <= samples; i++) lengths[i] *= scale;
+
+        lengths_ = lengths;
+        samples_ = samples;
+    }
+
     T at(float t) const
     {
         if (hasTangent_) {
@@ -207,7 +297,7 @@ struct Value<T, Position> {
              */
             VBezier b =
                 VBezier::fromPoints(start_, outTangent_, inTangent_, end_);
-            return b.pointAt(b.tAtLength(t * length_, length_));
+            return b.pointAt(tAtProgress(b, t));
         }
         return lerp(start_, end_, t);
     }
@@ -217,44 +307,120 @@ struct Value<T, Position> {
         if (hasTangent_) {
             VBezier b =
                 VBezier::fromPoints(start_, outTangent_, inTangent_, end_);
-            return b.angleAt(b.tAtLength(t * length_, length_));
+            return b.angleAt(tAtProgress(b, t));
         }
         return 0;
     }
+
+private:
+    float tAtProgress(const VBezier &b, float t) const
+    {
+        auto l = t * length_;
+        if (!lengths_) return b.tAtLength(l, length_);
+        if (l > length_ || vCompare(l, length_)) return 1;
+        if (l <= 0) return 0;
+
+        auto next = std::upper_bound(lengths_ + 1, lengths_ + samples_, l);
+        auto i = int(next - lengths_) - 1;
+        auto span = lengths_[i + 1] - lengths_[i];
+        auto fraction = vIsZero(span) ? 0 : (l - lengths_[i]) / span;
+        return (i + fraction) / samples_;
+    }
+
+public:
+    const float *lengths_{nullptr};
+    int          samples_{0};
 };
 
+/*
+ * Eased progress of the whole frames of a keyframe, indexed by the frame
+ * offset from its start, so playback loads the progress instead of solving
+ * the bezier. A table only depends on the easing and the keyframe length,
+ * the keyframes of a composition share it. The tables live in the arena
+ * of the composition, the index is only needed while it is being loaded.
+ */
+class EasingTables {
+public:
+    // longest keyframe that gets a table, in frames.
+    static constexpr int MaxLength = 512;
+
+    const float *table(VArenaAlloc &allocator, const VInterpolator *interpolator,
+                       float start, float end)
+    {
+        if (!interpolator || interpolator->isLinear()) return nullptr;
+
+        // the table index must give the same progress as the frame number.
+        if (start != std::floor(start) || end != std::floor(end) ||
+            std::fabs(start) > MaxFrame || std::fabs(end) > MaxFrame)
+            return nullptr;
+        auto length = end - start;
+        if (length < 1 || length > MaxLength) return nullptr;
+
+        auto &table = mTables[{interpolator, int(length)}];
+        if (!table) {
+            table = allocator.makeArrayDefault<float>(size_t(length));
+            for (int i = 0; i < int(length); i++)
+                table[i] = interpolator->value(i / length);
+        }
+        return table;
+    }
+
+private:
+    // frame numbers up to this convert to float exactly.
+    static constexpr float MaxFrame = 1 << 24;
+
+    using Key = std::pair<const VInterpolator *, int>;
+    struct KeyHash {
+        size_t operator()(const Key &key) const
+        {
+            return std::hash<const VInterpolator *>()(key.first) ^
+                   (size_t(key.second) * 0x9e3779b9);
+        }
+    };
+    std::unordered_map<Key, float *, KeyHash> mTables;
+};
+
+/*
+ * The loaders collect the keyframes of a property in keyFrames_, freeze()
+ * then moves them to two arrays in the composition arena: the timings,
+ * which the lookup searches, and the values, which are only read for the
+ * keyframe found. The arrays are sized exactly and lie next to the other
+ * keyframes of the composition.
+ */
 template <typename T, typename Tag>
 class KeyFrames {
 public:
     struct Frame {
+        // only valid for the frames in [start_, end_).
         float progress(int frameNo) const
         {
+            if (easing_) return easing_[frameNo - int(start_)];
             return interpolator_ ? interpolator_->value((frameNo - start_) /
                                                         (end_ - start_))
                                  : 0;
         }
-        T     value(int frameNo) const { return value_.at(progress(frameNo)); }
-        float angle(int frameNo) const
+        bool contains(int frameNo) const
         {
-            return value_.angle(progress(frameNo));
+            return frameNo >= start_ && frameNo < end_;
         }
 
         float          start_{0};
         float          end_{0};
         VInterpolator *interpolator_{nullptr};
-        Value<T, Tag>  value_;
+        const float *  easing_{nullptr};
+    };
+    // a keyframe as the loaders build it.
+    struct KeyFrame : Frame {
+        Value<T, Tag> value_;
     };
 
     T value(int frameNo) const
     {
-        if (frames_.front().start_ >= frameNo)
-            return frames_.front().value_.start_;
-        if (frames_.back().end_ <= frameNo) return frames_.back().value_.end_;
+        if (frames_.front().start_ >= frameNo) return values_.front().start_;
+        if (frames_.back().end_ <= frameNo) return values_.back().end_;
 
-        for (const auto &keyFrame : frames_) {
-            if (frameNo >= keyFrame.start_ && frameNo < keyFrame.end_)
-                return keyFrame.value(frameNo);
-        }
+        if (auto frame = find(frameNo))
+            return valueOf(frame).at(frame->progress(frameNo));
         return {};
     }
 
@@ -264,13 +430,48 @@ public:
             (frames_.back().end_ <= frameNo))
             return 0;
 
-        for (const auto &frame : frames_) {
-            if (frameNo >= frame.start_ && frameNo < frame.end_)
-                return frame.angle(frameNo);
-        }
+        if (auto frame = find(frameNo))
+            return valueOf(frame).angle(frame->progress(frameNo));
         return 0;
     }
 
+    /*
+     * the first frame that holds frameNo, or nullptr. Playback mostly
+     * asks for the frame of the last lookup or the one after it, so that
+     * is checked before the binary search. The cursor is only a hint,
+     * racing updates from other render threads are harmless.
+     */
+    const Frame *find(int frameNo) const
+    {
+        if (!ordered()) {
+            for (const auto &frame : frames_) {
+                if (frame.contains(frameNo)) return &frame;
+            }
+            return nullptr;
+        }
+
+        auto count = frames_.size();
+        auto index = size_t(cursor_.load(std::memory_order_relaxed));
+        if (index < count && frames_[index].contains(frameNo))
+            return &frames_[index];
+        if (++index < count && frames_[index].contains(frameNo)) {
+            cursor_.store(uint32_t(index), std::memory_order_relaxed);
+            return &frames_[index];
+        }
+
+        auto it = std::upper_bound(
+            frames_.begin(), frames_.end(), frameNo,
+            [](int frameNo, const Frame &frame) { return frameNo < frame.end_; });
+        if (it == frames_.end() || !it->contains(frameNo)) return nullptr;
+
+        cursor_.store(uint32_t(it - frames_.begin()), std::memory_order_relaxed);
+        return &*it;
+    }
+    const Value<T, Tag> &valueOf(const Frame *frame) const
+    {
+        return values_[size_t(frame - frames_.data())];
+    }
+
     bool changed(int prevFrame, int curFrame) const
     {
         auto first = frames_.front().start_;
@@ -281,11 +482,64 @@ public:
     }
     void cache()
     {
-        for (auto &e : frames_) e.value_.cache();
+        for (auto &e : keyFrames_) e.value_.cache();
     }
+    void freeze(EasingTables &tables, VArenaAlloc &allocator)
+    {
+        auto count = keyFrames_.size();
+        if (!count) return;
+
+        auto frames = allocator.makeArrayDefault<Frame>(count);
+        auto values = allocator.makeArrayDefault<Value<T, Tag>>(count);
+        for (size_t i = 0; i < count; i++) {
+            auto &e = keyFrames_[i];
+            frames[i] = e;
+            frames[i].easing_ =
+                tables.table(allocator, e.interpolator_, e.start_, e.end_);
+            values[i] = std::move(e.value_);
+            values[i].setupTables(allocator);
+        }
+        frames_ = VSpan<const Frame>(frames, count);
+        values_ = VSpan<const Value<T, Tag>>(values, count);
+        std::vector<KeyFrame>().swap(keyFrames_);
+    }
+    size_t size() const { return frames_.size(); }
+
+private:
+    /*
+     * the frames hold disjoint ranges in increasing order, so a frame can
+     * be searched for. Keyframe times out of order leave overlapping
+     * ranges, those are scanned linearly for the first match.
+     */
+    bool ordered() const
+    {
+        auto order = order_.load(std::memory_order_relaxed);
+        if (order == Order::Unknown) {
+            order = Order::Sorted;
+            for (size_t i = 0; i < frames_.size(); i++) {
+                if (frames_[i].start_ > frames_[i].end_ ||
+                    (i + 1 < frames_.size() &&
+                     frames_[i].end_ > frames_[i + 1].start_)) {
+                    order = Order::Unsorted;
+                    break;
+                }
+            }
+            order_.store(order, std::memory_order_relaxed);
+        }
+        return order == Order::Sorted;
+    }
+
+    enum class Order : uint8_t { Unknown, Sorted, Unsorted };
 
 public:
-    std::vector<Frame> frames_;
+    // filled by the loaders, emptied by freeze().
+    std::vector<KeyFrame>      keyFrames_;
+    VSpan<const Frame>         frames_;
+    VSpan<const Value<T, Tag>> values_;
+
+private:
+    mutable std::atomic<uint32_t> cursor_{0};
+    mutable std::atomic<Order>    order_{Order::Unknown};
 };
 
 template <typename T, typename Tag = void>
@@ -347,17 +601,16 @@ public:
         if (isStatic()) {
             value().toPath(path);
         } else {
-            const auto &vec = animation().frames_;
-            if (vec.front().start_ >= frameNo)
-                return vec.front().value_.start_.toPath(path);
-            if (vec.back().end_ <= frameNo)
-                return vec.back().value_.end_.toPath(path);
-
-            for (const auto &keyFrame : vec) {
-                if (frameNo >= keyFrame.start_ && frameNo < keyFrame.end_) {
-                    T::lerp(keyFrame.value_.start_, keyFrame.value_.end_,
-                            keyFrame.progress(frameNo), path);
-                }
+            const auto &anim = animation();
+            if (anim.frames_.front().start_ >= frameNo)
+                return anim.values_.front().start_.toPath(path);
+            if (anim.frames_.back().end_ <= frameNo)
+                return anim.values_.back().end_.toPath(path);
+
+            if (auto frame = anim.find(frameNo)) {
+                const auto &value = anim.valueOf(frame);
+                T::lerp(value.start_, value.end_, frame->progress(frameNo),
+                        path);
             }
         }
     }
@@ -375,6 +628,10 @@ public:
     {
         if (!isStatic()) animation().cache();
     }
+    void freeze(EasingTables &tables, VArenaAlloc &allocator)
+    {
+        if (!isStatic()) animation().freeze(tables, allocator);
+    }
 
 private:
     template <typename Tp>
@@ -646,6 +903,13 @@ public:
         }
     }
     const char *name() const { return shortString() ? mData._buffer : mPtr; }
+    // keypaths no longer match the object.
+    void clearName()
+    {
+        if (!shortString() && mPtr) free(mPtr);
+        setShortString(true);
+        mData._buffer[0] = '\0';
+    }
 
 private:
     static constexpr unsigned char maxShortStringLength = 14;
@@ -697,6 +961,15 @@ public:
             unsigned char d = input.at(i);
             uint32_t r = 0;
 
+            // a truncated sequence would read past the end.
+            unsigned int trail = ((d & 0xe0) == 0xc0)   ? 1
+                                 : ((d & 0xf0) == 0xe0) ? 2
+                                 : ((d & 0xf8) == 0xf0) ? 3
+                                 : ((d & 0xfc) == 0xf8) ? 4
+                                 : ((d & 0xfe) == 0xfc) ? 5
+                                                        : 0;
+            if (i + trail >= input.size()) return false;
+
             // FIXME: Need to handle error cases.
             if ((d & 0x80) == 0) {              // 1 byte
                 out.push_back((uint32_t)d);
@@ -864,13 +1137,32 @@ public:
     }
 };
 
+/*
+ * Image assets keep the encoded image, or its file path, and decode it
+ * the first time a renderer asks for the bitmap. The decoded bitmap can
+ * be released and gets decoded again on the next use.
+ * Renderers on different threads share the decoded bitmap through the
+ * atomic count of its handle, the bitmap itself is never copied so the
+ * count of VBitmap stays thread local.
+ */
 struct Asset {
     enum class Type : unsigned char { Precomp, Image, Char };
     bool                  isStatic() const { return mStatic; }
     void                  setStatic(bool value) { mStatic = value; }
-    VBitmap               bitmap() const { return mBitmap; }
+    // the decoded image, null if it can't be decoded.
+    std::shared_ptr<const VBitmap> bitmap() const;
+    void                  setBitmap(VBitmap bitmap);
     void                  loadImageData(std::string data);
     void                  loadImagePath(std::string Path);
+    // the encoded image, empty for a file path or a decoded only image.
+    const std::string &   imageData() const { return mImageData; }
+    // drops the decoded image if it can be decoded again.
+    void                  releaseImage();
+    // bytes held by the encoded image and by the decoded one.
+    size_t                encodedImageMemory() const;
+    size_t                decodedImageMemory() const;
+    // drops the content of an asset no layer refers to.
+    void                  release();
     Type                  mAssetType{Type::Precomp};
     bool                  mStatic{true};
     std::string           mRefId;  // ref id
@@ -878,7 +1170,13 @@ struct Asset {
     // image asset data
     int     mWidth{0};
     int     mHeight{0};
-    VBitmap mBitmap;
+
+private:
+    std::string        mImageData;
+    std::string        mImagePath;
+    mutable std::shared_ptr<const VBitmap> mBitmap;
+    mutable bool       mDecodeFailed{false};
+    mutable std::mutex mMutex;
 };
 
 class Fonts {
@@ -963,8 +1261,18 @@ public:
     size_t startFrame() const { return mStartFrame; }
     size_t endFrame() const { return mEndFrame; }
     VSize  size() const { return mSize; }
-    void   processRepeaterObjects();
-    void   updateStats();
+    bool   isFrameIdentical(int prevFrame, int curFrame) const;
+    struct MemoryStats;
+    // bytes held by the model, including the decoded images.
+    MemoryStats memoryStats() const;
+    size_t      memoryUsage() const;
+    // drops the decoded images, they get decoded again when rendered.
+    void        releaseImages() const;
+    void        processRepeaterObjects();
+    void        foldStaticContent();
+    // drops what only keypaths and introspection read.
+    void        dropMetadata();
+    void        updateStats();
 
 public:
     struct Stats {
@@ -974,6 +1282,18 @@ public:
         uint16_t imageLayerCount{0};
         uint16_t nullLayerCount{0};
     };
+    struct MemoryStats {
+        size_t keyframes{0};  // keyframes of the animated properties
+        size_t paths{0};      // PathData points, static and animated
+        size_t arena{0};      // arena blocks holding the model objects
+        size_t images{0};     // decoded images
+        size_t fonts{0};      // font entries and glyph outlines
+        size_t other{0};      // strings, containers and the rest
+        size_t total() const
+        {
+            return keyframes + paths + arena + images + fonts + other;
+        }
+    };
 
 public:
     std::string                              mVersion;
@@ -984,10 +1304,13 @@ public:
     BlendMode                                mBlendMode{BlendMode::Normal};
     Layer *                                  mRootLayer{nullptr};
     std::unordered_map<std::string, Asset *> mAssets;
+    // sorted, disjoint [first, last] ranges of frames with the same content.
+    std::vector<std::pair<int, int>>         mIdenticalFrames;
 
     std::vector<Marker> mMarkers;
     FontDB              mFontDB;
-    VArenaAlloc         mArenaAlloc{2048};
+    // filled once while loading, small blocks keep the unused tail small.
+    VArenaAlloc         mArenaAlloc{2048, 16384};
     Stats               mStats;
 };
 
@@ -1031,6 +1354,11 @@ public:
             impl.mData = data;
         }
     }
+    void set(const VMatrix &matrix, float opacity)
+    {
+        setStatic(true);
+        new (&impl.mStaticData) StaticData(VMatrix(matrix), opacity);
+    }
     VMatrix matrix(int frameNo, bool autoOrient = false) const
     {
         if (isStatic()) return impl.mStaticData.mMatrix;
@@ -1041,6 +1369,7 @@ public:
         if (isStatic()) return impl.mStaticData.mOpacity;
         return impl.mData->opacity(frameNo);
     }
+    const Data *data() const { return isStatic() ? nullptr : impl.mData; }
     Transform(const Transform &) = delete;
     Transform(Transform &&) = delete;
     Transform &operator=(Transform &) = delete;
@@ -1113,7 +1442,7 @@ struct TextData {
 
 class TextDocument {
 public:
-    int           mTime;                               /* "t" */
+    int           mTime{0};                            /* "t" */
 
     /* The folloing values are member of a object "s". */
     int           mSize{0};                            /* "s" */
@@ -1163,13 +1492,14 @@ public:
 
 class TextLayerData {
 private:
+    // a document holds from its time till the time of the next one.
     TextDocument &textDocument(int frameNo)
     {
-        for (auto &textDocument : mTextDocument) {
-            if (textDocument.mTime >= frameNo)
-                return textDocument;
-        }
-        return mTextDocument.back();
+        auto it = mTextDocument.begin();
+        while (std::next(it) != mTextDocument.end() &&
+               std::next(it)->mTime <= frameNo)
+            ++it;
+        return *it;
     }
 
 public:
@@ -1474,6 +1804,11 @@ public:
     bool                     mEnabled{true}; /* "fillEnabled" */
 };
 
+inline size_t valueHeapSize(const Gradient::Data &gradient)
+{
+    return gradient.mGradient.capacity() * sizeof(float);
+}
+
 class GradientStroke : public Gradient {
 public:
     GradientStroke() : Gradient(Object::Type::GStroke) {}
@@ -1538,7 +1873,9 @@ public:
     Path() : Shape(Object::Type::Path) {}
 
 public:
-    Property<PathData> mShape;
+    Property<PathData>    mShape;
+    // static sibling paths merged into this one, drawn after mShape.
+    std::vector<PathData> mMerged;
 };
 
 class RoundedCorner : public Object {
@@ -1764,21 +2101,60 @@ using ColorFilter = std::function<void(float &, float &, float &)>;
 
 void configureModelCacheSize(size_t cacheSize);
 
+void configureModelCacheBudget(size_t bytes);
+
+struct CacheStats {
+    size_t hits{0};
+    size_t misses{0};
+    size_t coalesced{0};
+    size_t evictions{0};
+    size_t entries{0};
+    size_t bytes{0};
+};
+
+CacheStats modelCacheStats();
+
+// the models currently held by the cache.
+std::vector<std::shared_ptr<model::Composition>> cachedModels();
+
+// pulls the next chunk of input into buffer, returns 0 at the end of input.
+using ChunkReader = std::function<size_t(char *buffer, size_t size)>;
+
+// dropMetadata loads a model without the data Composition::dropMetadata()
+// removes, such models are cached apart from the full ones.
 std::shared_ptr<model::Composition> loadFromFile(const std::string &filePath,
-                                                 bool cachePolicy);
+                                                 bool               cachePolicy,
+                                                 bool dropMetadata = false);
 
 std::shared_ptr<model::Composition> loadFromData(std::string        jsonData,
                                                  const std::string &key,
                                                  std::string resourcePath,
-                                                 bool        cachePolicy);
+                                                 bool        cachePolicy,
+                                                 bool dropMetadata = false);
 
 std::shared_ptr<model::Composition> loadFromData(std::string jsonData,
                                                  std::string resourcePath,
-                                                 ColorFilter filter);
+                                                 ColorFilter filter,
+                                                 const std::string &filterKey);
+
+std::shared_ptr<model::Composition> loadFromStream(
+    ChunkReader reader, const std::string &key, std::string resourcePath,
+    bool cachePolicy);
 
 std::shared_ptr<model::Composition> parse(char *str, size_t length, std::string dir_path,
                                           ColorFilter filter = {});
 
+std::shared_ptr<model::Composition> parse(ChunkReader reader, std::string dir_path,
+                                          ColorFilter filter = {});
+
+// precompiled binary form of a parsed model, see lottiebinary.cpp.
+bool isBinary(const char *data, size_t length);
+
+std::string serialize(const Composition &comp);
+
+std::shared_ptr<model::Composition> deserialize(const char *data, size_t length,
+                                                ColorFilter filter = {});
+
 }  // namespace model
 
 }  // namespace internal
@@ -51,11 +51,36 @@
 // returned null), you should not call SkipArray().
 //
 // This parser uses in-situ strings, so the JSON buffer will be altered during
-// the parse.
+// the parse. When it reads from a ChunkStream instead, strings are copied out
+// of the chunk buffer as the buffer gets reused.
 
 #include <array>
+#include <deque>
 
 #include "lottiemodel.h"
+
+// let rapidjson skip whitespace and scan strings 16 bytes at a time where
+// the target has the instructions for it. The scanners load whole aligned
+// blocks, which may reach past the end of the input. That can't fault but
+// trips the address sanitizer, so they are left out of such builds.
+#if defined(__SANITIZE_ADDRESS__)
+#define LOTTIE_JSON_SCALAR_SCAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define LOTTIE_JSON_SCALAR_SCAN
+#endif
+#endif
+
+#ifndef LOTTIE_JSON_SCALAR_SCAN
+#if defined(__SSE4_2__)
+#define RAPIDJSON_SSE42
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAPIDJSON_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define RAPIDJSON_NEON
+#endif
+#endif
+
 #include "rapidjson/document.h"
 #include "zip/zip.h"
 
@@ -68,6 +93,97 @@ using namespace rapidjson;
 
 using namespace rlottie::internal;
 
+/*
+ * Read stream over a chunk reader, modelled after rapidjson::FileReadStream.
+ * Only one buffer of the input is resident at a time, it is refilled as the
+ * parser consumes it so parsing proceeds while the input is still being
+ * read. The end of the input reads as '\0'.
+ */
+class ChunkStream {
+public:
+    typedef char Ch;
+
+    explicit ChunkStream(model::ChunkReader reader)
+        : mReader(std::move(reader)), mBuffer(BufferSize + 1)
+    {
+        fill();
+    }
+
+    Ch     Peek() const { return *mCurrent; }
+    Ch     Take()
+    {
+        Ch c = *mCurrent;
+        read();
+        return c;
+    }
+    size_t Tell() const { return mCount + size_t(mCurrent - mBuffer.data()); }
+
+    // Not implemented
+    void   Put(Ch) { RAPIDJSON_ASSERT(false); }
+    void   Flush() { RAPIDJSON_ASSERT(false); }
+    Ch *   PutBegin() { RAPIDJSON_ASSERT(false); return nullptr; }
+    size_t PutEnd(Ch *) { RAPIDJSON_ASSERT(false); return 0; }
+
+    // the buffered input not consumed yet, to sniff the data format.
+    const char *buffered() const { return mCurrent; }
+    size_t      available() const
+    {
+        return size_t(mBuffer.data() + mReadCount - mCurrent);
+    }
+
+    // the rest of the input in one piece, for formats that need it whole.
+    std::string drain()
+    {
+        std::string data(mCurrent, available());
+        while (!mEof) {
+            fill();
+            data.append(mBuffer.data(), mReadCount);
+        }
+        mCurrent = mLast;
+        return data;
+    }
+
+private:
+    static constexpr size_t BufferSize = 64 * 1024;
+
+    void read()
+    {
+        if (mCurrent < mLast)
+            ++mCurrent;
+        else if (!mEof)
+            fill();
+    }
+
+    void fill()
+    {
+        mCount += mReadCount;
+        mReadCount = 0;
+        // readers may return less than asked, fill the whole buffer so a
+        // short read is only seen at the end of the input.
+        while (mReadCount < BufferSize) {
+            auto n = mReader(mBuffer.data() + mReadCount,
+                             BufferSize - mReadCount);
+            if (!n) break;
+            mReadCount += std::min(n, BufferSize - mReadCount);
+        }
+        mCurrent = mBuffer.data();
+        mLast = mCurrent + mReadCount - 1;
+        if (mReadCount < BufferSize) {
+            mBuffer[mReadCount] = '\0';
+            ++mLast;
+            mEof = true;
+        }
+    }
+
+    model::ChunkReader mReader;
+    std::vector<char>  mBuffer;
+    char *             mCurrent{nullptr};
+    char *             mLast{nullptr};
+    size_t             mReadCount{0};
+    size_t             mCount{0};
+    bool               mEof{false};
+};
+
 class LookaheadParserHandler {
 public:
     bool Null()
@@ -113,26 +229,44 @@ public:
         return true;
     }
     bool RawNumber(const char *, SizeType, bool) { return false; }
-    bool String(const char *str, SizeType length, bool)
+    bool String(const char *str, SizeType length, bool copy)
     {
         st_ = kHasString;
+        if (copy) {
+            // one string is always looked ahead, so keep the last two.
+            auto &buf = strings_[lastString_ ^= 1];
+            buf.assign(str, length);
+            str = buf.c_str();
+        }
         v_.SetString(str, length);
         return true;
     }
     bool StartObject()
     {
         st_ = kEnteringObject;
+        ++depth_;
         return true;
     }
-    bool Key(const char *str, SizeType length, bool)
+    bool Key(const char *str, SizeType length, bool copy)
     {
         st_ = kHasKey;
+        if (copy) {
+            // a key has to outlive the parse of its value, which may be a
+            // nested object, and the lookahead of the next key, so keep the
+            // last two per nesting level.
+            if (keys_.size() < depth_) keys_.resize(depth_);
+            auto &keys = keys_[depth_ - 1];
+            auto &buf = keys.buf[keys.last ^= 1];
+            buf.assign(str, length);
+            str = buf.c_str();
+        }
         v_.SetString(str, length);
         return true;
     }
     bool EndObject(SizeType)
     {
         st_ = kExitingObject;
+        if (depth_) --depth_;
         return true;
     }
     bool StartArray()
@@ -152,6 +286,7 @@ public:
     }
 protected:
     explicit LookaheadParserHandler(char *str);
+    explicit LookaheadParserHandler(ChunkStream &stream);
 
 protected:
     enum LookaheadParsingState {
@@ -172,6 +307,15 @@ protected:
     LookaheadParsingState st_;
     Reader                r_;
     InsituStringStream    ss_;
+    ChunkStream *         cs_{nullptr};
+    size_t                depth_{0};
+    struct KeyBuffer {
+        std::string buf[2];
+        int         last{0};
+    };
+    std::deque<KeyBuffer> keys_;
+    std::string           strings_[2];
+    int                   lastString_{0};
 
     static const int parseFlags = kParseDefaultFlags | kParseInsituFlag;
 };
@@ -184,6 +328,13 @@ public:
           mDirPath(std::move(dir_path))
     {
     }
+    LottieParserImpl(ChunkStream &stream, std::string dir_path,
+                     model::ColorFilter filter)
+        : LookaheadParserHandler(stream),
+          mColorFilter(std::move(filter)),
+          mDirPath(std::move(dir_path))
+    {
+    }
     bool VerifyType();
     bool ParseNext();
 
@@ -287,6 +438,10 @@ public:
 
     void parseShapeProperty(model::Property<model::PathData> &obj);
     void parseDashProperty(model::Dash &dash);
+    template <typename T, typename Tag>
+    void addAnimatedRange(const model::KeyFrames<T, Tag> &obj);
+    bool layerChanged(const model::Layer *layer, int prevFrame, int curFrame);
+    void updateIdenticalFrames(model::Composition *comp);
 
     VInterpolator *interpolator(VPointF, VPointF, std::string);
 
@@ -379,10 +534,15 @@ private:
 
 protected:
     std::unordered_map<std::string, VInterpolator *> mInterpolatorCache;
+    model::EasingTables                              mEasingTables;
     std::shared_ptr<model::Composition>              mComposition;
     model::Composition *                             compRef{nullptr};
     model::Layer *                                   curLayerRef{nullptr};
     std::vector<model::Layer *>                      mLayersToUpdate;
+    // keyframe ranges of the animated properties of each layer.
+    std::unordered_map<const model::Layer *,
+                       std::vector<std::pair<float, float>>>
+                                                     mAnimatedRanges;
     std::string                                      mDirPath;
     void                                             SkipOut(int depth);
 };
@@ -393,6 +553,12 @@ LookaheadParserHandler::LookaheadParserHandler(char *str)
     r_.IterativeParseInit();
 }
 
+LookaheadParserHandler::LookaheadParserHandler(ChunkStream &stream)
+    : v_(), st_(kInit), ss_(nullptr), cs_(&stream)
+{
+    r_.IterativeParseInit();
+}
+
 bool LottieParserImpl::VerifyType()
 {
     /* Verify the media type is lottie json.
@@ -407,7 +573,9 @@ bool LottieParserImpl::ParseNext()
         return false;
     }
 
-    if (!r_.IterativeParseNext<parseFlags>(ss_, *this)) {
+    bool ok = cs_ ? r_.IterativeParseNext<kParseDefaultFlags>(*cs_, *this)
+                  : r_.IterativeParseNext<parseFlags>(ss_, *this);
+    if (!ok) {
         vCritical << "Lottie file parsing error";
         st_ = kError;
         return false;
@@ -649,6 +817,70 @@ model::BlendMode LottieParserImpl::getBlendMode()
     return mode;
 }
 
+template <typename T, typename Tag>
+void LottieParserImpl::addAnimatedRange(const model::KeyFrames<T, Tag> &obj)
+{
+    if (!curLayerRef || obj.frames_.empty()) return;
+
+    mAnimatedRanges[curLayerRef].emplace_back(obj.frames_.front().start_,
+                                              obj.frames_.back().end_);
+}
+
+/*
+ * Conservative check, a layer has changed if its visibility changed or
+ * if one of its properties or precomp children is animated between the
+ * two frames. follows the rule of model::KeyFrames::changed().
+ */
+bool LottieParserImpl::layerChanged(const model::Layer *layer, int prevFrame,
+                                    int curFrame)
+{
+    bool prevVisible =
+        prevFrame >= layer->inFrame() && prevFrame <= layer->outFrame();
+    bool curVisible =
+        curFrame >= layer->inFrame() && curFrame <= layer->outFrame();
+    if (prevVisible != curVisible) return true;
+
+    // check the properties even when hidden as the layer can be a parent.
+    auto search = mAnimatedRanges.find(layer);
+    if (search != mAnimatedRanges.end()) {
+        for (const auto &range : search->second) {
+            if (!((range.first > prevFrame && range.first > curFrame) ||
+                  (range.second < prevFrame && range.second < curFrame)))
+                return true;
+        }
+    }
+
+    if (!curVisible || !layer->precompLayer()) return false;
+
+    int prevMapped = layer->timeRemap(prevFrame);
+    int curMapped = layer->timeRemap(curFrame);
+    if (prevMapped == curMapped) return false;
+
+    for (const auto &child : layer->mChildren) {
+        if (layerChanged(static_cast<const model::Layer *>(child), prevMapped,
+                         curMapped))
+            return true;
+    }
+    return false;
+}
+
+void LottieParserImpl::updateIdenticalFrames(model::Composition *comp)
+{
+    int start = int(comp->mStartFrame);
+    int end = int(comp->mEndFrame);
+    int rangeStart = start;
+
+    for (int frameNo = start + 1; frameNo <= end; frameNo++) {
+        if (!layerChanged(comp->mRootLayer, frameNo - 1, frameNo)) continue;
+        if (frameNo - 1 > rangeStart)
+            comp->mIdenticalFrames.emplace_back(rangeStart, frameNo - 1);
+        rangeStart = frameNo;
+    }
+    if (end > rangeStart) comp->mIdenticalFrames.emplace_back(rangeStart, end);
+
+    mAnimatedRanges.clear();
+}
+
 void LottieParserImpl::resolveLayerRefs()
 {
     for (const auto &layer : mLayersToUpdate) {
@@ -719,6 +951,7 @@ void LottieParserImpl::parseComposition()
     comp->setStatic(comp->mRootLayer->isStatic());
     comp->mRootLayer->mInFrame = comp->mStartFrame;
     comp->mRootLayer->mOutFrame = comp->mEndFrame;
+    updateIdenticalFrames(comp);
 
     mComposition = sharedComposition;
 }
@@ -790,13 +1023,13 @@ void LottieParserImpl::parseTextDocument(model::TextLayerData *obj)
     RAPIDJSON_ASSERT(PeekType() == kArrayType);
     EnterArray();
 
-    obj->mTextDocument.emplace_back();
-    model::TextDocument &documentObj = obj->mTextDocument.back();
-
+    // one document per keyframe.
     while (NextArrayValue()) {
         RAPIDJSON_ASSERT(PeekType() == kObjectType);
         EnterObject();
 
+        obj->mTextDocument.emplace_back();
+        model::TextDocument &documentObj = obj->mTextDocument.back();
         while (const char *key = NextObjectKey()) {
             if (0 == strcmp(key, "s")) {
                 parseTextProperties(documentObj);
@@ -807,6 +1040,8 @@ void LottieParserImpl::parseTextDocument(model::TextLayerData *obj)
             }
         }
     }
+    // the renderer expects a document.
+    if (obj->mTextDocument.empty()) obj->mTextDocument.emplace_back();
 }
 
 void LottieParserImpl::parseTextAnimatedProperties(model::TextAnimator &obj)
@@ -1418,8 +1653,14 @@ model::Layer *LottieParserImpl::parseLayer()
         } else if (0 == strcmp(key, "hd")) {
             layer->setHidden(GetBool());
         } else if (0 == strcmp(key, "t")) {
-            parseText(layer->extra()->textLayer());
-            staticFlag = layer->extra()->textLayer()->isStatic();
+            auto text = layer->extra()->textLayer();
+            parseText(text);
+            staticFlag = text->isStatic();
+            // the text changes at the document keyframes.
+            const auto &documents = text->mTextDocument;
+            if (documents.size() > 1)
+                mAnimatedRanges[layer].emplace_back(documents.front().mTime,
+                                                    documents.back().mTime);
         } else {
 #ifdef DEBUG_PARSER
             vWarning << "Layer Attribute Skipped : " << key;
@@ -1884,11 +2125,9 @@ model::Repeater *LottieParserImpl::parseReapeaterObject()
             parseProperty(obj->mCopies);
             float maxCopy = 0.0;
             if (!obj->mCopies.isStatic()) {
-                for (auto &keyFrame : obj->mCopies.animation().frames_) {
-                    if (maxCopy < keyFrame.value_.start_)
-                        maxCopy = keyFrame.value_.start_;
-                    if (maxCopy < keyFrame.value_.end_)
-                        maxCopy = keyFrame.value_.end_;
+                for (auto &value : obj->mCopies.animation().values_) {
+                    if (maxCopy < value.start_) maxCopy = value.start_;
+                    if (maxCopy < value.end_) maxCopy = value.end_;
                 }
             } else {
                 maxCopy = obj->mCopies.value();
@@ -2336,7 +2575,7 @@ void LottieParserImpl::parsePathInfo()
 void LottieParserImpl::getValue(model::PathData &obj)
 {
     parsePathInfo();
-    obj.mPoints = mPathInfo.mResult;
+    obj.assign(allocator(), mPathInfo.mResult.data(), mPathInfo.mResult.size());
     obj.mClosed = mPathInfo.mClosed;
 }
 
@@ -2409,7 +2648,7 @@ void LottieParserImpl::parseKeyFrame(model::KeyFrames<T, Tag> &obj)
 
     EnterObject();
     ParsedField                              parsed;
-    typename model::KeyFrames<T, Tag>::Frame keyframe;
+    typename model::KeyFrames<T, Tag>::KeyFrame keyframe;
     VPointF                                  inTangent;
     VPointF                                  outTangent;
 
@@ -2458,7 +2697,7 @@ void LottieParserImpl::parseKeyFrame(model::KeyFrames<T, Tag> &obj)
         }
     }
 
-    auto &list = obj.frames_;
+    auto &list = obj.keyFrames_;
     if (!list.empty()) {
         // update the endFrame value of current keyframe
         list.back().end_ = keyframe.start_;
@@ -2513,6 +2752,8 @@ void LottieParserImpl::parseShapeProperty(model::Property<model::PathData> &obj)
         }
     }
     obj.cache();
+    obj.freeze(mEasingTables, allocator());
+    if (!obj.isStatic()) addAnimatedRange(obj.animation());
 }
 
 template <typename T, typename Tag>
@@ -2549,6 +2790,8 @@ void LottieParserImpl::parsePropertyHelper(model::Property<T, Tag> &obj)
             }
         }
         obj.cache();
+        obj.freeze(mEasingTables, allocator());
+        if (!obj.isStatic()) addAnimatedRange(obj.animation());
     }
 }
 
@@ -2769,47 +3012,48 @@ static char* uncompressZip(const char * str, size_t length)
     //Read a representive animation
     if (zip_entry_openbyindex(zip, 1)) {
         vCritical << errMsg;
+        zip_stream_close(zip);
         return nullptr;
     }
 
     char* buf = nullptr;
-    size_t bufSize;
+    size_t bufSize = 0;
     zip_entry_read(zip, (void**)&buf, &bufSize);
 
     zip_entry_close(zip);
     zip_stream_close(zip);
 
-    return buf;
+    if (!buf) {
+        vCritical << errMsg;
+        return nullptr;
+    }
+
+    //the in situ parser needs a null terminated buffer.
+    auto data = static_cast<char*>(realloc(buf, bufSize + 1));
+    if (!data) {
+        free(buf);
+        return nullptr;
+    }
+    data[bufSize] = '\0';
+
+    return data;
 }
 
-static bool checkDotLottie(const char * str)
+static bool checkDotLottie(const char * str, size_t length)
 {
     //check the .Lottie signature.
-    if (str[0] == 0x50 && str[1] == 0x4B && str[2] == 0x03 && str[3] == 0x04) return true;
+    if (length >= 4 && str[0] == 0x50 && str[1] == 0x4B && str[2] == 0x03 && str[3] == 0x04) return true;
     else return false;
 }
 
-std::shared_ptr<model::Composition> model::parse(char *             str,
-                                                 size_t             length,
-                                                 std::string        dir_path,
-                                                 model::ColorFilter filter)
+static std::shared_ptr<model::Composition> parseDocument(LottieParserImpl &obj)
 {
-    auto input = str;
-
-    auto dotLottie = checkDotLottie(str);
-    if (dotLottie) {
-        input = uncompressZip(str, length);
-    }
-
-    LottieParserImpl obj(input, std::move(dir_path), std::move(filter));
-
-    if (dotLottie) free(input);
-
     if (obj.VerifyType()) {
         obj.parseComposition();
         auto composition = obj.composition();
         if (composition) {
             composition->processRepeaterObjects();
+            composition->foldStaticContent();
             composition->updateStats();
 
 #ifdef LOTTIE_DUMP_TREE_SUPPORT
@@ -2825,4 +3069,43 @@ std::shared_ptr<model::Composition> model::parse(char *             str,
     return {};
 }
 
+std::shared_ptr<model::Composition> model::parse(char *             str,
+                                                 size_t             length,
+                                                 std::string        dir_path,
+                                                 model::ColorFilter filter)
+{
+    if (isBinary(str, length)) return deserialize(str, length, std::move(filter));
+
+    auto input = str;
+
+    //the parser works in situ, the unzipped data lives till the end.
+    std::unique_ptr<char, decltype(&free)> unzipped(nullptr, &free);
+    if (checkDotLottie(str, length)) {
+        unzipped.reset(uncompressZip(str, length));
+        if (!unzipped) return {};
+        input = unzipped.get();
+    }
+
+    LottieParserImpl obj(input, std::move(dir_path), std::move(filter));
+    return parseDocument(obj);
+}
+
+std::shared_ptr<model::Composition> model::parse(model::ChunkReader reader,
+                                                 std::string        dir_path,
+                                                 model::ColorFilter filter)
+{
+    ChunkStream stream(std::move(reader));
+
+    // the binary form and dotLottie archives are decoded from memory.
+    if (isBinary(stream.buffered(), stream.available()) ||
+        checkDotLottie(stream.buffered(), stream.available())) {
+        auto data = stream.drain();
+        return parse(&data[0], data.size(), std::move(dir_path),
+                     std::move(filter));
+    }
+
+    LottieParserImpl obj(stream, std::move(dir_path), std::move(filter));
+    return parseDocument(obj);
+}
+
 RAPIDJSON_DIAG_POP
@@ -16,13 +16,16 @@ static uint32_t first_allocated_block(uint32_t blockSize, uint32_t firstHeapAllo
            blockSize           > 0 ? blockSize           : 1024;
 }
 
-VArenaAlloc::VArenaAlloc(char* block, size_t size, size_t firstHeapAllocation)
+VArenaAlloc::VArenaAlloc(char* block, size_t size, size_t firstHeapAllocation,
+                         size_t maxHeapAllocation)
     : fDtorCursor {block}
     , fCursor     {block}
     , fEnd        {block + ToU32(size)}
     , fFirstBlock {block}
     , fFirstSize  {ToU32(size)}
     , fFirstHeapAllocationSize  {first_allocated_block(ToU32(size), ToU32(firstHeapAllocation))}
+    , fMaxHeapAllocationSize  {maxHeapAllocation > 0 ? ToU32(maxHeapAllocation)
+                                                     : std::numeric_limits<uint32_t>::max()}
 {
     if (size < sizeof(Footer)) {
         fEnd = fCursor = fDtorCursor = nullptr;
@@ -39,7 +42,8 @@ VArenaAlloc::~VArenaAlloc() {
 
 void VArenaAlloc::reset() {
     this->~VArenaAlloc();
-    new (this) VArenaAlloc{fFirstBlock, fFirstSize, fFirstHeapAllocationSize};
+    new (this) VArenaAlloc{fFirstBlock, fFirstSize, fFirstHeapAllocationSize,
+                           fMaxHeapAllocationSize};
 }
 
 void VArenaAlloc::installFooter(FooterAction* action, uint32_t padding) {
@@ -79,13 +83,24 @@ void VArenaAlloc::RunDtorsOnBlock(char* footerEnd) {
     }
 }
 
+// The objects of the block are destroyed at this point, the block is freed before going on
+// with the older blocks. Returning the chain instead of recursing keeps the stack flat for
+// arenas with many blocks.
 char* VArenaAlloc::NextBlock(char* footerEnd) {
     char* objEnd = footerEnd - (sizeof(Footer) + sizeof(char*));
     char* next;
     memmove(&next, objEnd, sizeof(char*));
-    RunDtorsOnBlock(next);
     delete [] objEnd;
-    return nullptr;
+    return next;
+}
+
+// Leaves the current block for the chain of a block holding oversized data, the rest of the
+// current block is reached through that chain.
+char* VArenaAlloc::NextChain(char* footerEnd) {
+    char* objEnd = footerEnd - (sizeof(Footer) + sizeof(char*));
+    char* next;
+    memmove(&next, objEnd, sizeof(char*));
+    return next;
 }
 
 void VArenaAlloc::installUint32Footer(FooterAction* action, uint32_t value, uint32_t padding) {
@@ -94,6 +109,37 @@ void VArenaAlloc::installUint32Footer(FooterAction* action, uint32_t value, uint
     this->installFooter(action, padding);
 }
 
+uint32_t VArenaAlloc::nextBlockSize() const {
+    if (fFirstHeapAllocationSize > fMaxHeapAllocationSize / fFib0) return fMaxHeapAllocationSize;
+    return fFirstHeapAllocationSize * fFib0;
+}
+
+char* VArenaAlloc::allocOversized(uint32_t size, uint32_t alignment) {
+    constexpr uint32_t linkSize = sizeof(char*) + sizeof(Footer);
+    constexpr uint32_t maxSize = std::numeric_limits<uint32_t>::max();
+    // The current block needs room for the link to the new one.
+    if (fCursor == nullptr || fEnd - fCursor < (ptrdiff_t)linkSize) return nullptr;
+    AssertRelease(size <= maxSize - linkSize - alignment);
+    uint32_t allocationSize = size + linkSize + alignment - 1;
+    // Smaller data leaves little of the current block unused.
+    if (allocationSize <= this->nextBlockSize() / 4) return nullptr;
+
+    char* newBlock = new char[allocationSize];
+    fAllocated += allocationSize;
+
+    // The new block frees itself and goes on with the chain built so far, the current block
+    // continues with the new one.
+    char* cursor = fCursor;
+    fCursor = newBlock;
+    this->installPtrFooter(NextBlock, fDtorCursor, 0);
+    char* newChain = fDtorCursor;
+    fCursor = cursor;
+    this->installPtrFooter(NextChain, newChain, 0);
+
+    uintptr_t mask = alignment - 1;
+    return (char*)((uintptr_t)(newBlock + linkSize + mask) & ~mask);
+}
+
 void VArenaAlloc::ensureSpace(uint32_t size, uint32_t alignment) {
     constexpr uint32_t headerSize = sizeof(Footer) + sizeof(ptrdiff_t);
     // The chrome c++ library we use does not define std::max_align_t.
@@ -110,13 +156,10 @@ void VArenaAlloc::ensureSpace(uint32_t size, uint32_t alignment) {
         objSizeAndOverhead += alignmentOverhead;
     }
 
-    uint32_t minAllocationSize;
-    if (fFirstHeapAllocationSize <= maxSize / fFib0) {
-        minAllocationSize = fFirstHeapAllocationSize * fFib0;
+    uint32_t minAllocationSize = this->nextBlockSize();
+    if (minAllocationSize < fMaxHeapAllocationSize) {
         fFib0 += fFib1;
         std::swap(fFib0, fFib1);
-    } else {
-        minAllocationSize = maxSize;
     }
     uint32_t allocationSize = std::max(objSizeAndOverhead, minAllocationSize);
 
@@ -129,6 +172,7 @@ void VArenaAlloc::ensureSpace(uint32_t size, uint32_t alignment) {
     }
 
     char* newBlock = new char[allocationSize];
+    fAllocated += allocationSize;
 
     auto previousDtor = fDtorCursor;
     fCursor = newBlock;
@@ -54,16 +54,19 @@
 // bytes. For arrays of non-POD objects there is a per array overhead of typically 8 bytes. There
 // is an addition overhead when switching from POD data to non-POD data of typically 8 bytes.
 //
-// If additional blocks are needed they are increased exponentially. This strategy bounds the
-// recursion of the RunDtorsOnBlock to be limited to O(log size-of-memory). Block size grow using
+// If additional blocks are needed they are increased exponentially. Block size grow using
 // the Fibonacci sequence which means that for 2^32 memory there are 48 allocations, and for 2^48
-// there are 71 allocations.
+// there are 71 allocations. A maxHeapAllocation caps the block size, it bounds the unused tail
+// of the last block for arenas that are filled once and kept.
+// POD data that doesn't fit and takes more than a quarter of the next block gets a block of its
+// own, the current block stays in use.
 class VArenaAlloc {
 public:
-    VArenaAlloc(char* block, size_t blockSize, size_t firstHeapAllocation);
+    VArenaAlloc(char* block, size_t blockSize, size_t firstHeapAllocation,
+                size_t maxHeapAllocation = 0);
 
-    explicit VArenaAlloc(size_t firstHeapAllocation)
-        : VArenaAlloc(nullptr, 0, firstHeapAllocation)
+    explicit VArenaAlloc(size_t firstHeapAllocation, size_t maxHeapAllocation = 0)
+        : VArenaAlloc(nullptr, 0, firstHeapAllocation, maxHeapAllocation)
     {}
 
     ~VArenaAlloc();
@@ -74,8 +77,7 @@ public:
         uint32_t alignment = ToU32(alignof(T));
         char* objStart;
         if (std::is_trivially_destructible<T>::value) {
-            objStart = this->allocObject(size, alignment);
-            fCursor = objStart + size;
+            objStart = this->allocPod(size, alignment);
         } else {
             objStart = this->allocObjectWithFooter(size + sizeof(Footer), alignment);
             // Can never be UB because max value is alignof(T).
@@ -122,14 +124,15 @@ public:
 
     // Only use makeBytesAlignedTo if none of the typed variants are impractical to use.
     void* makeBytesAlignedTo(size_t size, size_t align) {
-        auto objStart = this->allocObject(ToU32(size), ToU32(align));
-        fCursor = objStart + size;
-        return objStart;
+        return this->allocPod(ToU32(size), ToU32(align));
     }
 
     // Destroy all allocated objects, free any heap allocations.
     void reset();
 
+    // bytes of the blocks allocated on the heap.
+    size_t allocatedBytes() const { return fAllocated; }
+
 private:
     static void AssertRelease(bool cond) { if (!cond) { ::abort(); } }
     static uint32_t ToU32(size_t v) {
@@ -142,12 +145,15 @@ private:
     static char* SkipPod(char* footerEnd);
     static void RunDtorsOnBlock(char* footerEnd);
     static char* NextBlock(char* footerEnd);
+    static char* NextChain(char* footerEnd);
 
     void installFooter(FooterAction* releaser, uint32_t padding);
     void installUint32Footer(FooterAction* action, uint32_t value, uint32_t padding);
     void installPtrFooter(FooterAction* action, char* ptr, uint32_t padding);
 
+    uint32_t nextBlockSize() const;
     void ensureSpace(uint32_t size, uint32_t alignment);
+    char* allocOversized(uint32_t size, uint32_t alignment);
 
     char* allocObject(uint32_t size, uint32_t alignment) {
         uintptr_t mask = alignment - 1;
@@ -162,6 +168,18 @@ private:
         return fCursor + alignedOffset;
     }
 
+    // Places POD data and moves the cursor past it.
+    char* allocPod(uint32_t size, uint32_t alignment) {
+        uintptr_t mask = alignment - 1;
+        uintptr_t alignedOffset = (~reinterpret_cast<uintptr_t>(fCursor) + 1) & mask;
+        if (size + alignedOffset > static_cast<uintptr_t>(fEnd - fCursor)) {
+            if (char* objStart = this->allocOversized(size, alignment)) return objStart;
+        }
+        char* objStart = this->allocObject(size, alignment);
+        fCursor = objStart + size;
+        return objStart;
+    }
+
     char* allocObjectWithFooter(uint32_t sizeIncludingFooter, uint32_t alignment);
 
     template <typename T>
@@ -172,8 +190,7 @@ private:
         uint32_t alignment = ToU32(alignof(T));
 
         if (std::is_trivially_destructible<T>::value) {
-            objStart = this->allocObject(arraySize, alignment);
-            fCursor = objStart + arraySize;
+            objStart = this->allocPod(arraySize, alignment);
         } else {
             constexpr uint32_t overhead = sizeof(Footer) + sizeof(uint32_t);
             AssertRelease(arraySize <= std::numeric_limits<uint32_t>::max() - overhead);
@@ -210,11 +227,13 @@ private:
     char* const    fFirstBlock;
     const uint32_t fFirstSize;
     const uint32_t fFirstHeapAllocationSize;
+    const uint32_t fMaxHeapAllocationSize;
 
     // Use the Fibonacci sequence as the growth factor for block size. The size of the block
     // allocated is fFib0 * fFirstHeapAllocationSize. Using 2 ^ n * fFirstHeapAllocationSize
     // had too much slop for Android.
     uint32_t       fFib0 {1}, fFib1 {1};
+    size_t         fAllocated {0};
 };
 
 // Helper for defining allocators with inline/reserved storage.
@@ -183,6 +183,21 @@ void VRasterBuffer::clear()
     memset(mBuffer, 0, mHeight * mBytesPerLine);
 }
 
+void VRasterBuffer::clear(const VRect &rect)
+{
+    if (rect.empty()) return;
+
+    if (rect.left() == 0 && size_t(rect.width()) == mWidth) {
+        memset(scanLine(rect.top()), 0, rect.height() * mBytesPerLine);
+        return;
+    }
+
+    for (int y = rect.top(); y < rect.bottom(); y++) {
+        memset(scanLine(y) + rect.left() * mBytesPerPixel, 0,
+               rect.width() * mBytesPerPixel);
+    }
+}
+
 VBitmap::Format VRasterBuffer::prepare(const VBitmap *image)
 {
     mBuffer = image->data();
@@ -124,6 +124,7 @@ class VRasterBuffer {
 public:
     VBitmap::Format prepare(const VBitmap *image);
     void            clear();
+    void            clear(const VRect &rect);
 
     void resetBuffer(int val = 0);
 
@@ -129,6 +129,9 @@ static void src_SourceOver(uint32_t *dest, int length, const uint32_t *src,
          * dest = source' + dest ( 1- source'a)
          */
         for (int i = 0; i < length; ++i) {
+            // BYTE_MUL(d, 255) is not exact, so a transparent source would
+            // still darken the destination.
+            if (src[i] == 0) continue;
             s = BYTE_MUL(src[i], alpha);
             sia = vAlpha(~s);
             dest[i] = s + BYTE_MUL(dest[i], sia);
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "vexecutor.h"
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+V_BEGIN_NAMESPACE
+
+namespace {
+struct ExecutorConfig {
+    std::mutex            mutex;
+    /*
+     * read for every raster task, so it doesn't take the mutex. The flag
+     * keeps the common case, no application executor, to a single load.
+     */
+    std::atomic<bool>                          external{false};
+    std::shared_ptr<const VExecutor::Callback> callback;
+    size_t                count[4]{0, 0, 0, 0};
+    std::vector<int>      cpus;
+};
+
+ExecutorConfig &config()
+{
+    static ExecutorConfig config;
+    return config;
+}
+}  // namespace
+
+void VExecutor::setCallback(Callback callback)
+{
+    std::shared_ptr<const Callback> shared;
+    if (callback) shared = std::make_shared<const Callback>(std::move(callback));
+
+    std::lock_guard<std::mutex> lock(config().mutex);
+    bool external = bool(shared);
+    std::atomic_store(&config().callback, std::move(shared));
+    config().external.store(external, std::memory_order_release);
+}
+
+bool VExecutor::external()
+{
+    return config().external.load(std::memory_order_acquire);
+}
+
+void VExecutor::submit(Task task)
+{
+    if (!external()) {
+        task();
+        return;
+    }
+    auto callback = std::atomic_load(&config().callback);
+    if (callback)
+        (*callback)(std::move(task));
+    else
+        task();
+}
+
+void VExecutor::setThreadCount(Pool pool, size_t count)
+{
+    std::lock_guard<std::mutex> lock(config().mutex);
+    config().count[size_t(pool)] = count;
+}
+
+unsigned VExecutor::threadCount(Pool pool)
+{
+    std::lock_guard<std::mutex> lock(config().mutex);
+    auto count = config().count[size_t(pool)];
+    if (!count) count = std::thread::hardware_concurrency();
+    return unsigned(count);
+}
+
+void VExecutor::setAffinity(std::vector<int> cpus)
+{
+    std::lock_guard<std::mutex> lock(config().mutex);
+    config().cpus = std::move(cpus);
+}
+
+void VExecutor::applyAffinity(unsigned index)
+{
+#ifdef __linux__
+    int cpu;
+    {
+        std::lock_guard<std::mutex> lock(config().mutex);
+        if (config().cpus.empty()) return;
+        cpu = config().cpus[index % config().cpus.size()];
+    }
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)index;
+#endif
+}
+
+V_END_NAMESPACE
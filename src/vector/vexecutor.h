@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VEXECUTOR_H
+#define VEXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "vglobal.h"
+
+V_BEGIN_NAMESPACE
+
+/*
+ * Process wide settings of the worker thread pools (render, band and
+ * raster). The pools read them when they start, on first use.
+ */
+class VExecutor {
+public:
+    enum class Pool { Render, Band, Raster, Load };
+    using Task = std::function<void()>;
+    using Callback = std::function<void(Task task)>;
+
+    // run the tasks of every pool on the application executor, no
+    // thread gets created.
+    static void setCallback(Callback callback);
+    static bool external();
+    static void submit(Task task);
+
+    // 0 uses the number of hardware threads.
+    static void     setThreadCount(Pool pool, size_t count);
+    static unsigned threadCount(Pool pool);
+
+    // thread i of a pool runs on cpus[i % cpus.size()], empty to not pin.
+    static void setAffinity(std::vector<int> cpus);
+    static void applyAffinity(unsigned index);
+
+    /*
+     * Calls fn(i) for each i in [begin, end) and returns once all the
+     * calls are done. Helper tasks are handed to submit(), the calling
+     * thread takes its share of the work instead of blocking, so it never
+     * waits for a helper stuck in a busy queue or executor.
+     */
+    template <typename Submit>
+    static void parallelFor(size_t begin, size_t end,
+                            const std::function<void(size_t)> &fn,
+                            Submit &&submit);
+};
+
+template <typename Submit>
+void VExecutor::parallelFor(size_t begin, size_t end,
+                            const std::function<void(size_t)> &fn,
+                            Submit &&submit)
+{
+    struct State {
+        std::atomic<size_t>                next;
+        std::atomic<size_t>                pending;
+        size_t                             end;
+        const std::function<void(size_t)> *fn;
+        std::mutex                         mutex;
+        std::condition_variable            cv;
+    };
+    if (begin >= end) return;
+
+    auto state = std::make_shared<State>();
+    state->next = begin;
+    state->pending = end - begin;
+    state->end = end;
+    state->fn = &fn;
+
+    // late helpers find nothing left and never touch fn.
+    auto work = [state] {
+        size_t i;
+        while ((i = state->next++) < state->end) {
+            (*state->fn)(i);
+            if (--state->pending == 0) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cv.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = begin + 1; i < end; i++) submit(Task(work));
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->pending == 0; });
+}
+
+V_END_NAMESPACE
+
+#endif  // VEXECUTOR_H
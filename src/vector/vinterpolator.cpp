@@ -47,7 +47,7 @@ float VInterpolator::GetSlope(float aT, float aA1, float aA2)
 
 float VInterpolator::value(float aX) const
 {
-    if (mX1 == mY1 && mX2 == mY2) return aX;
+    if (isLinear()) return aX;
 
     return CalcBezier(GetTForX(aX), mY1, mY2);
 }
@@ -49,6 +49,10 @@ public:
 
     void GetSplineDerivativeValues(float aX, float& aDX, float& aDY) const;
 
+    VPointF p1() const { return VPointF(mX1, mY1); }
+    VPointF p2() const { return VPointF(mX2, mY2); }
+    bool    isLinear() const { return mX1 == mY1 && mX2 == mY2; }
+
 private:
     void CalcSampleValues();
 
@@ -35,8 +35,41 @@ void VPainter::drawRle(const VPoint &, const VRle &rle)
     if (!mSpanData.mUnclippedBlendFunc) return;
 
     // do draw after applying clip.
-    rle.intersect(mSpanData.clipRect(), mSpanData.mUnclippedBlendFunc,
-                  &mSpanData);
+    rle.intersect(mClipRect, mSpanData.mUnclippedBlendFunc, &mSpanData);
+}
+
+struct ClipSpanData {
+    VRect      mClip;
+    VSpanData *mSpanData;
+};
+
+// clips the spans to a rect before forwarding them to the blend function.
+static void clipSpanCb(size_t count, const VRle::Span *spans, void *userData)
+{
+    auto *        data = static_cast<ClipSpanData *>(userData);
+    const VRect & clip = data->mClip;
+    const size_t  nspans = 256;
+    VRle::Span    result[nspans];
+    size_t        n = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const auto &span = spans[i];
+        if (span.y < clip.top() || span.y >= clip.bottom()) continue;
+
+        auto x1 = std::max(int(span.x), clip.left());
+        auto x2 = std::min(span.x + span.len, clip.right());
+        if (x2 <= x1) continue;
+
+        result[n].x = short(x1);
+        result[n].y = span.y;
+        result[n].len = uint16_t(x2 - x1);
+        result[n].coverage = span.coverage;
+        if (++n == nspans) {
+            data->mSpanData->mUnclippedBlendFunc(n, result, data->mSpanData);
+            n = 0;
+        }
+    }
+    if (n) data->mSpanData->mUnclippedBlendFunc(n, result, data->mSpanData);
 }
 
 void VPainter::drawRle(const VRle &rle, const VRle &clip)
@@ -45,15 +78,20 @@ void VPainter::drawRle(const VRle &rle, const VRle &clip)
 
     if (!mSpanData.mUnclippedBlendFunc) return;
 
-    rle.intersect(clip, mSpanData.mUnclippedBlendFunc, &mSpanData);
+    if (mClipRect.contains(rle.boundingRect())) {
+        rle.intersect(clip, mSpanData.mUnclippedBlendFunc, &mSpanData);
+    } else {
+        ClipSpanData data{mClipRect, &mSpanData};
+        rle.intersect(clip, clipSpanCb, &data);
+    }
 }
 
-static void fillRect(const VRect &r, VSpanData *data)
+static void fillRect(const VRect &r, const VRect &clip, VSpanData *data)
 {
-    auto x1 = std::max(r.x(), 0);
-    auto x2 = std::min(r.x() + r.width(), data->mDrawableSize.width());
-    auto y1 = std::max(r.y(), 0);
-    auto y2 = std::min(r.y() + r.height(), data->mDrawableSize.height());
+    auto x1 = std::max(r.x(), clip.x());
+    auto x2 = std::min(r.x() + r.width(), clip.right());
+    auto y1 = std::max(r.y(), clip.y());
+    auto y2 = std::min(r.y() + r.height(), clip.bottom());
 
     if (x2 <= x1 || y2 <= y1) return;
 
@@ -89,7 +127,7 @@ void VPainter::drawBitmapUntransform(const VRect &  target,
     mSpanData.dx = float(target.x() - source.x());
     mSpanData.dy = float(target.y() - source.y());
 
-    fillRect(target, &mSpanData);
+    fillRect(target, mClipRect, &mSpanData);
 }
 
 VPainter::VPainter(VBitmap *buffer)
@@ -100,15 +138,32 @@ bool VPainter::begin(VBitmap *buffer)
 {
     mBuffer.prepare(buffer);
     mSpanData.init(&mBuffer);
+    mClipRect = mSpanData.clipRect();
     // TODO find a better api to clear the surface
     mBuffer.clear();
     return true;
 }
+
+bool VPainter::begin(VBitmap *buffer, const VRect &clip)
+{
+    mBuffer.prepare(buffer);
+    mSpanData.init(&mBuffer);
+    mClipRect = mSpanData.clipRect() & clip;
+    mBuffer.clear(mClipRect);
+    return true;
+}
+
 void VPainter::end() {}
 
 void VPainter::setDrawRegion(const VRect &region)
 {
     mSpanData.setDrawRegion(region);
+    mClipRect = mSpanData.clipRect();
+}
+
+void VPainter::setClipRect(const VRect &clip)
+{
+    mClipRect = mSpanData.clipRect() & clip;
 }
 
 void VPainter::setBrush(const VBrush &brush)
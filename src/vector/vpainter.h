@@ -36,8 +36,11 @@ public:
     VPainter() = default;
     explicit VPainter(VBitmap *buffer);
     bool  begin(VBitmap *buffer);
+    bool  begin(VBitmap *buffer, const VRect &clip); // clears and draws only inside clip.
     void  end();
     void  setDrawRegion(const VRect &region); // sub surface rendering area.
+    void  setClipRect(const VRect &clip);     // in draw region coordinate.
+    VRect clipRect() const { return mClipRect; }
     void  setBrush(const VBrush &brush);
     void  setBlendMode(BlendMode mode);
     void  drawRle(const VPoint &pos, const VRle &rle);
@@ -53,6 +56,7 @@ private:
                                const VRect &source, uint8_t const_alpha);
     VRasterBuffer mBuffer;
     VSpanData     mSpanData;
+    VRect         mClipRect;
 };
 
 V_END_NAMESPACE
@@ -27,6 +27,7 @@
 #include "v_ft_raster.h"
 #include "v_ft_stroker.h"
 #include "vdebug.h"
+#include "vexecutor.h"
 #include "vmatrix.h"
 #include "vpath.h"
 #include "vrle.h"
@@ -296,6 +297,12 @@ public:
         return _rle;
     }
 
+    size_t memoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _ready ? _rle.memoryUsage() : 0;
+    }
+
     void reset()
     {
         wait();
@@ -321,12 +328,50 @@ struct VRleTask {
     CapStyle  mCap;
     JoinStyle mJoin;
     bool      mGenerateStroke;
+    int       mPriority{0};
+    bool      mDeferred{false};
+    std::atomic<bool> mClaimed{true};
+    std::shared_ptr<const std::atomic<bool>> mCancelled;
+
+    // the first caller computes the pending request, the others wait.
+    bool claim() { return !mClaimed.exchange(true); }
+    void release() { mClaimed.store(false); }
+
+    VRle &rle()
+    {
+        // not picked up by a worker yet, compute it instead of waiting.
+        if (claim()) compute();
+        mRle.get();
+        if (mDeferred) {
+            // dropped by the worker, compute it on the calling thread.
+            mDeferred = false;
+            compute();
+        }
+        return mRle.unsafe();
+    }
 
-    VRle &rle() { return mRle.get(); }
+    bool cancelled() const { return mCancelled && mCancelled->load(); }
+
+    void defer()
+    {
+        mDeferred = true;
+        mCancelled.reset();
+        mRle.notify();
+    }
+
+    void compute();
+
+    // a request that didn't start yet is replaced by the next update.
+    void drop()
+    {
+        if (claim()) mRle.notify();
+    }
 
     void update(VPath path, FillRule fillRule, const VRect &clip)
     {
+        drop();
         mRle.reset();
+        mDeferred = false;
         mPath = std::move(path);
         mFillRule = fillRule;
         mClip = clip;
@@ -336,7 +381,9 @@ struct VRleTask {
     void update(VPath path, CapStyle cap, JoinStyle join, float width,
                 float miterLimit, const VRect &clip)
     {
+        drop();
         mRle.reset();
+        mDeferred = false;
         mPath = std::move(path);
         mCap = cap;
         mJoin = join;
@@ -373,6 +420,9 @@ struct VRleTask {
     {
         if (mPath.points().size() > SHRT_MAX ||
             mPath.points().size() + mPath.segments() > SHRT_MAX) {
+            // too big for the rasterizer, don't leave the waiter hanging.
+            mRle.unsafe().reset();
+            mRle.notify();
             return;
         }
 
@@ -415,6 +465,58 @@ struct VRleTask {
 
 using VTask = std::shared_ptr<VRleTask>;
 
+// per thread objects used to compute the rle.
+struct VRasterScratch {
+    VRasterScratch() { SW_FT_Stroker_New(&stroker); }
+    ~VRasterScratch() { SW_FT_Stroker_Done(stroker); }
+    FTOutline     outline{};
+    SW_FT_Stroker stroker;
+};
+
+void VRleTask::compute()
+{
+    static thread_local VRasterScratch scratch;
+    (*this)(scratch.outline, scratch.stroker);
+}
+
+// entry point of the worker threads and of the external executor.
+static void execute(VRleTask &task)
+{
+    if (!task.claim()) return;
+
+    // stale work, leave it to whoever still needs the rle.
+    if (task.cancelled())
+        task.defer();
+    else
+        task.compute();
+}
+
+struct VRasterRequest {
+    int                                      priority{0};
+    std::shared_ptr<const std::atomic<bool>> cancelled;
+};
+
+static VRasterRequest &rasterRequest()
+{
+    static thread_local VRasterRequest request;
+    return request;
+}
+
+VRasterRequestScope::VRasterRequestScope(
+    int priority, std::shared_ptr<const std::atomic<bool>> cancelled)
+    : mPriority(rasterRequest().priority),
+      mCancelled(std::move(rasterRequest().cancelled))
+{
+    rasterRequest().priority = priority;
+    rasterRequest().cancelled = std::move(cancelled);
+}
+
+VRasterRequestScope::~VRasterRequestScope()
+{
+    rasterRequest().priority = mPriority;
+    rasterRequest().cancelled = std::move(mCancelled);
+}
+
 #ifdef LOTTIE_THREAD_SUPPORT
 
 #include <thread>
@@ -425,27 +527,25 @@ using VTask = std::shared_ptr<VRleTask>;
 #include <sstream>
 #endif
 
+struct VTaskPriority {
+    int operator()(const VTask &task) const { return task->mPriority; }
+};
+
 class RleTaskScheduler {
-    const unsigned                _count{std::thread::hardware_concurrency()};
+    const unsigned _count{VExecutor::threadCount(VExecutor::Pool::Raster)};
     std::vector<std::thread>      _threads;
-    std::vector<TaskQueue<VTask>> _q{_count};
+    std::vector<TaskQueue<VTask, VTaskPriority>> _q{_count};
     std::atomic<unsigned>         _index{0};
 
     void run(unsigned i)
     {
-        /*
-         * initalize  per thread objects.
-         */
-        FTOutline     outlineRef;
-        SW_FT_Stroker stroker;
-        SW_FT_Stroker_New(&stroker);
-
         // Create Thread Name for Debugging (Linux)
 #ifdef __linux__
         std::ostringstream nameStream;
         nameStream << "lottie-tsk-" << i;
         pthread_setname_np(pthread_self(), nameStream.str().c_str());
 #endif
+        VExecutor::applyAffinity(i);
 
         // Task Loop
         VTask task;
@@ -461,11 +561,8 @@ class RleTaskScheduler {
 
             if (!success && !_q[i].pop(task)) break;
 
-            (*task)(outlineRef, stroker);
+            execute(*task);
         }
-
-        // cleanup
-        SW_FT_Stroker_Done(stroker);
     }
 
     RleTaskScheduler()
@@ -515,10 +612,6 @@ public:
 #else
 
 class RleTaskScheduler {
-public:
-    FTOutline     outlineRef{};
-    SW_FT_Stroker stroker;
-
 public:
     static bool IsRunning;
 
@@ -530,11 +623,7 @@ public:
 
     void stop() {}
 
-    RleTaskScheduler() { SW_FT_Stroker_New(&stroker); }
-
-    ~RleTaskScheduler() { SW_FT_Stroker_Done(stroker); }
-
-    void process(VTask task) { (*task)(outlineRef, stroker); }
+    void process(VTask task) { execute(*task); }
 };
 #endif
 
@@ -553,6 +642,12 @@ VRle VRasterizer::rle()
     return d->rle();
 }
 
+size_t VRasterizer::memoryUsage() const
+{
+    if (!d) return 0;
+    return d->task().mRle.memoryUsage();
+}
+
 void VRasterizer::init()
 {
     if (!d) d = std::make_shared<VRasterizerImpl>();
@@ -560,7 +655,16 @@ void VRasterizer::init()
 
 void VRasterizer::updateRequest()
 {
+    d->task().mPriority = rasterRequest().priority;
+    d->task().mCancelled = rasterRequest().cancelled;
+    d->task().release();
     VTask taskObj = VTask(d, &d->task());
+#ifdef LOTTIE_THREAD_SUPPORT
+    if (VExecutor::external()) {
+        VExecutor::submit([taskObj] { execute(*taskObj); });
+        return;
+    }
+#endif
     RleTaskScheduler::instance().process(std::move(taskObj));
 }
 
@@ -22,6 +22,7 @@
 
 #ifndef VRASTER_H
 #define VRASTER_H
+#include <atomic>
 #include <future>
 #include "vglobal.h"
 #include "vrect.h"
@@ -31,6 +32,23 @@ V_BEGIN_NAMESPACE
 class VPath;
 class VRle;
 
+/*
+ * Priority and cancel flag of the rasterization tasks requested by the
+ * calling thread while the scope is alive. A task whose request got
+ * cancelled is not computed by the worker threads, it is computed on
+ * demand if its rle is still needed.
+ */
+class VRasterRequestScope
+{
+public:
+    VRasterRequestScope(int priority,
+                        std::shared_ptr<const std::atomic<bool>> cancelled);
+    ~VRasterRequestScope();
+private:
+    int                                      mPriority;
+    std::shared_ptr<const std::atomic<bool>> mCancelled;
+};
+
 class VRasterizer
 {
 public:
@@ -38,6 +56,8 @@ public:
     void rasterize(VPath path, CapStyle cap, JoinStyle join, float width,
                    float miterLimit, const VRect &clip = VRect());
     VRle rle();
+    // bytes held by the last completed rle, 0 while one is being computed.
+    size_t memoryUsage() const;
 private:
     struct VRasterizerImpl;
     void init();
@@ -67,6 +67,8 @@ public:
     friend VRle operator&(const VRect &rect, const VRle &o);
 
     bool   unique() const { return d.unique(); }
+    // bytes held by the span storage.
+    size_t memoryUsage() const { return d->mSpans.capacity() * sizeof(Span); }
     size_t refCount() const { return d.refCount(); }
     void   clone(const VRle &o) { d.write().clone(o.d.read()); }
 
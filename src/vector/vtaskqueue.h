@@ -25,7 +25,20 @@
 
 #include <deque>
 
-template <typename Task>
+// default policy, all the tasks have the same priority.
+struct TaskNoPriority {
+    template <typename Task>
+    int operator()(const Task &) const
+    {
+        return 0;
+    }
+};
+
+/*
+ * Tasks with a higher Priority()(task) value are popped first, tasks with
+ * the same priority are popped in FIFO order.
+ */
+template <typename Task, typename Priority = TaskNoPriority>
 class TaskQueue {
     using lock_t = std::unique_lock<std::mutex>;
     std::deque<Task>      _q;
@@ -33,6 +46,14 @@ class TaskQueue {
     std::mutex              _mutex;
     std::condition_variable _ready;
 
+    void insert(Task &&task)
+    {
+        auto it = _q.end();
+        auto priority = Priority()(task);
+        while (it != _q.begin() && Priority()(*(it - 1)) < priority) --it;
+        _q.insert(it, std::move(task));
+    }
+
 public:
     bool try_pop(Task &task)
     {
@@ -48,7 +69,7 @@ public:
         {
             lock_t lock{_mutex, std::try_to_lock};
             if (!lock) return false;
-            _q.push_back(std::move(task));
+            insert(std::move(task));
         }
         _ready.notify_one();
         return true;
@@ -77,7 +98,7 @@ public:
     {
         {
             lock_t lock{_mutex};
-            _q.push_back(std::move(task));
+            insert(std::move(task));
         }
         _ready.notify_one();
     }
@@ -1,5 +1,12 @@
 #include <gtest/gtest.h>
 #include "rlottie.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 class AnimationTest : public ::testing::Test {
 public:
@@ -32,3 +39,714 @@ TEST_F(AnimationTest, loadFromFile) {
     ASSERT_EQ(width, 500);
     ASSERT_EQ(height, 500);
 }
+
+TEST_F(AnimationTest, loadDotLottie) {
+    auto dotLottie = rlottie::Animation::loadFromFile(DEMO_DIR "1st_animation.lottie", false);
+    ASSERT_TRUE(dotLottie != nullptr);
+    ASSERT_GT(dotLottie->totalFrame(), 0u);
+
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    dotLottie->renderSync(0, surface);
+}
+
+TEST_F(AnimationTest, renderAsync) {
+    ASSERT_TRUE(animation != nullptr);
+    std::vector<uint32_t> syncBuffer(100 * 100);
+    std::vector<uint32_t> asyncBuffer(100 * 100);
+    rlottie::Surface syncSurface(syncBuffer.data(), 100, 100, 100 * 4);
+    rlottie::Surface asyncSurface(asyncBuffer.data(), 100, 100, 100 * 4);
+
+    animation->renderSync(10, syncSurface);
+    auto future = animation->render(10, asyncSurface);
+    auto surface = future.get();
+    ASSERT_EQ(surface.buffer(), asyncBuffer.data());
+    ASSERT_EQ(syncBuffer, asyncBuffer);
+}
+
+TEST_F(AnimationTest, renderRequest) {
+    ASSERT_TRUE(animation != nullptr);
+    std::vector<uint32_t> syncBuffer(100 * 100);
+    std::vector<uint32_t> requestBuffer(100 * 100);
+    rlottie::Surface syncSurface(syncBuffer.data(), 100, 100, 100 * 4);
+    rlottie::Surface requestSurface(requestBuffer.data(), 100, 100, 100 * 4);
+
+    animation->renderSync(10, syncSurface);
+    auto request = animation->requestRender(10, requestSurface,
+                                            rlottie::RenderPriority::High);
+    ASSERT_TRUE(request.valid());
+    ASSERT_EQ(request.priority(), rlottie::RenderPriority::High);
+    auto surface = request.get();
+    ASSERT_EQ(surface.buffer(), requestBuffer.data());
+    ASSERT_FALSE(request.cancelled());
+    ASSERT_FALSE(request.cancel());
+    ASSERT_EQ(syncBuffer, requestBuffer);
+
+    ASSERT_FALSE(rlottie::RenderRequest().valid());
+}
+
+TEST_F(AnimationTest, renderRequestCancel) {
+    ASSERT_TRUE(animation != nullptr);
+    std::vector<std::unique_ptr<rlottie::Animation>> players;
+    for (size_t i = 0; i < 16; i++) {
+        players.push_back(rlottie::Animation::loadFromFile(DEMO_DIR "mask.json"));
+        ASSERT_TRUE(players.back() != nullptr);
+    }
+
+    std::vector<uint32_t> expected(100 * 100);
+    std::vector<std::vector<uint32_t>> buffers(players.size(),
+                                               std::vector<uint32_t>(100 * 100));
+    for (size_t frameNo = 0; frameNo < 20; frameNo += 5) {
+        rlottie::Surface surface(expected.data(), 100, 100, 100 * 4);
+        animation->renderSync(frameNo, surface);
+
+        std::vector<rlottie::RenderRequest> requests;
+        for (size_t i = 0; i < players.size(); i++) {
+            rlottie::Surface target(buffers[i].data(), 100, 100, 100 * 4);
+            requests.push_back(players[i]->requestRender(
+                frameNo, target, rlottie::RenderPriority::Low));
+        }
+        for (auto &e : requests) e.cancel();
+        for (size_t i = 0; i < players.size(); i++) {
+            requests[i].get();
+            if (!requests[i].cancelled()) {
+                ASSERT_EQ(buffers[i], expected);
+            }
+        }
+
+        // a cancelled frame doesn't affect the next render.
+        for (size_t i = 0; i < players.size(); i++) {
+            rlottie::Surface target(buffers[i].data(), 100, 100, 100 * 4);
+            auto request = players[i]->requestRender(frameNo, target);
+            request.get();
+            ASSERT_FALSE(request.cancelled());
+            ASSERT_EQ(buffers[i], expected);
+        }
+    }
+}
+
+TEST_F(AnimationTest, executor) {
+    ASSERT_TRUE(animation != nullptr);
+    std::vector<uint32_t> syncBuffer(200 * 200);
+    std::vector<uint32_t> asyncBuffer(200 * 200);
+    rlottie::Surface syncSurface(syncBuffer.data(), 200, 200, 200 * 4);
+    rlottie::Surface asyncSurface(asyncBuffer.data(), 200, 200, 200 * 4);
+
+    auto other = rlottie::Animation::loadFromFile(DEMO_DIR "mask.json");
+    ASSERT_TRUE(other != nullptr);
+    other->setRenderBands(4);
+
+    static std::atomic<size_t> tasks{0};
+    rlottie::configureExecutor([](std::function<void()> task) {
+        tasks++;
+        std::thread(std::move(task)).detach();
+    });
+    for (size_t frameNo = 0; frameNo < animation->totalFrame(); frameNo += 4) {
+        animation->renderSync(frameNo, syncSurface);
+        other->render(frameNo, asyncSurface).get();
+        ASSERT_EQ(syncBuffer, asyncBuffer);
+    }
+    rlottie::configureExecutor(nullptr);
+    ASSERT_GT(tasks.load(), 0u);
+}
+
+TEST_F(AnimationTest, modelCache) {
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(2);
+    auto load = [](const char *name) {
+        return rlottie::Animation::loadFromFile(std::string(DEMO_DIR) + name);
+    };
+
+    auto start = rlottie::modelCacheStats();
+    ASSERT_EQ(start.entries, 0u);
+    ASSERT_EQ(start.bytes, 0u);
+    load("mask.json");
+    load("heart.json");
+    auto stats = rlottie::modelCacheStats();
+    ASSERT_EQ(stats.misses - start.misses, 2u);
+    ASSERT_EQ(stats.entries, 2u);
+    ASSERT_GT(stats.bytes, 0u);
+
+    // mask.json is the most recently used, heart.json gets evicted.
+    load("mask.json");
+    load("abstract_circle.json");
+    load("mask.json");
+    stats = rlottie::modelCacheStats();
+    ASSERT_EQ(stats.hits - start.hits, 2u);
+    ASSERT_EQ(stats.evictions - start.evictions, 1u);
+    load("heart.json");
+    stats = rlottie::modelCacheStats();
+    ASSERT_EQ(stats.misses - start.misses, 4u);
+
+    // a budget smaller than both models keeps only the latest one.
+    rlottie::configureModelCacheBudget(stats.bytes - 1);
+    stats = rlottie::modelCacheStats();
+    ASSERT_EQ(stats.entries, 1u);
+    ASSERT_EQ(stats.evictions - start.evictions, 3u);
+    load("heart.json");
+    ASSERT_EQ(rlottie::modelCacheStats().hits - start.hits, 3u);
+
+    rlottie::configureModelCacheBudget(0);
+    rlottie::configureModelCacheSize(10);
+}
+
+TEST_F(AnimationTest, loadAsync) {
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(10);
+    std::string path = std::string(DEMO_DIR) + "heart.json";
+
+    auto sync = rlottie::Animation::loadFromFile(path);
+    auto file = rlottie::Animation::loadFromFileAsync(path).get();
+    ASSERT_TRUE(file != nullptr);
+    ASSERT_EQ(file->totalFrame(), sync->totalFrame());
+    ASSERT_TRUE(rlottie::Animation::loadFromFileAsync(
+                    std::string(DEMO_DIR) + "notexist.json").get() == nullptr);
+
+    std::string json = "{\"v\":\"5.1.3\",\"fr\":30,\"ip\":0,\"op\":10,"
+                       "\"w\":100,\"h\":100,\"layers\":[]}";
+    auto data = rlottie::Animation::loadFromDataAsync(json, "loadAsync").get();
+    ASSERT_TRUE(data != nullptr);
+    size_t width, height;
+    data->size(width, height);
+    ASSERT_EQ(width, 100u);
+
+    // every request for the same key is served by a single parse.
+    auto start = rlottie::modelCacheStats();
+    std::vector<std::future<std::unique_ptr<rlottie::Animation>>> pending;
+    for (int i = 0; i < 8; i++) {
+        pending.push_back(
+            rlottie::Animation::loadFromDataAsync(json, "loadAsync-shared"));
+    }
+    for (auto &e : pending) ASSERT_TRUE(e.get() != nullptr);
+    auto stats = rlottie::modelCacheStats();
+    ASSERT_EQ(stats.misses - start.misses, 1u);
+    ASSERT_EQ((stats.hits - start.hits) + (stats.coalesced - start.coalesced),
+              7u);
+
+    auto batch = rlottie::Animation::loadFromFiles(
+        {path, std::string(DEMO_DIR) + "notexist.json", path,
+         std::string(DEMO_DIR) + "mask.json"});
+    ASSERT_EQ(batch.size(), 4u);
+    ASSERT_TRUE(batch[0] != nullptr);
+    ASSERT_TRUE(batch[1] == nullptr);
+    ASSERT_TRUE(batch[2] != nullptr);
+    ASSERT_TRUE(batch[3] != nullptr);
+    ASSERT_EQ(batch[2]->totalFrame(), sync->totalFrame());
+
+    // the lean model is cached apart, the sync load finds it.
+    rlottie::LoadOptions options;
+    options.noDynamicProperties = true;
+    auto lean = rlottie::Animation::loadFromFileAsync(path, options).get();
+    ASSERT_TRUE(lean != nullptr);
+    ASSERT_NE(std::get<0>(sync->layers()[0]), "");
+    ASSERT_EQ(std::get<0>(lean->layers()[0]), "");
+    start = rlottie::modelCacheStats();
+    ASSERT_TRUE(rlottie::Animation::loadFromFile(path, options) != nullptr);
+    ASSERT_EQ(rlottie::modelCacheStats().hits - start.hits, 1u);
+
+    auto leanData = rlottie::Animation::loadFromDataAsync(json, "loadAsync",
+                                                          "", options).get();
+    ASSERT_TRUE(leanData != nullptr);
+    ASSERT_TRUE(leanData->markers().empty());
+}
+
+TEST_F(AnimationTest, contentKey) {
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(10);
+    std::string json = "{\"v\":\"5.1.3\",\"fr\":30,\"ip\":0,\"op\":20,"
+                       "\"w\":100,\"h\":100,\"layers\":[]}";
+
+    // identical data without a key shares one model.
+    auto start = rlottie::modelCacheStats();
+    ASSERT_TRUE(rlottie::Animation::loadFromData(json, "") != nullptr);
+    ASSERT_TRUE(rlottie::Animation::loadFromData(std::string(json), "") != nullptr);
+    ASSERT_TRUE(rlottie::Animation::loadFromData(json, "", "/other/") != nullptr);
+    auto stats = rlottie::modelCacheStats();
+    ASSERT_EQ(stats.misses - start.misses, 2u);
+    ASSERT_EQ(stats.hits - start.hits, 1u);
+
+    // the filter identity is part of the key.
+    auto red = [](float &r, float &g, float &b) { r = 1; g = b = 0; };
+    start = rlottie::modelCacheStats();
+    ASSERT_TRUE(rlottie::Animation::loadFromData(json, "", red, "red") != nullptr);
+    ASSERT_TRUE(rlottie::Animation::loadFromData(json, "", red, "red") != nullptr);
+    ASSERT_TRUE(rlottie::Animation::loadFromData(json, "", red, "red2") != nullptr);
+    ASSERT_TRUE(rlottie::Animation::loadFromData(json, "", red) != nullptr);
+    stats = rlottie::modelCacheStats();
+    ASSERT_EQ(stats.misses - start.misses, 2u);
+    ASSERT_EQ(stats.hits - start.hits, 1u);
+}
+
+TEST_F(AnimationTest, binary) {
+    ASSERT_TRUE(animation != nullptr);
+    std::string binary = animation->toBinary();
+    ASSERT_FALSE(binary.empty());
+
+    auto loaded = rlottie::Animation::loadFromData(binary, "binary", "", false);
+    ASSERT_TRUE(loaded != nullptr);
+    ASSERT_EQ(loaded->totalFrame(), animation->totalFrame());
+    ASSERT_EQ(loaded->toBinary(), binary);
+
+    std::vector<uint32_t> buffer(100 * 100);
+    std::vector<uint32_t> binaryBuffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    rlottie::Surface binarySurface(binaryBuffer.data(), 100, 100, 100 * 4);
+    animation->renderSync(10, surface);
+    loaded->renderSync(10, binarySurface);
+    ASSERT_EQ(buffer, binaryBuffer);
+
+    std::string path = std::string(DEMO_DIR) + "mask.rlm";
+    ASSERT_TRUE(animation->saveBinary(path));
+    auto file = rlottie::Animation::loadFromFile(path, false);
+    std::remove(path.c_str());
+    ASSERT_TRUE(file != nullptr);
+    ASSERT_EQ(file->totalFrame(), animation->totalFrame());
+
+    // the composition blend mode follows the frame rate.
+    float frameRate = float(animation->frameRate());
+    std::string header(reinterpret_cast<const char *>(&frameRate), sizeof(frameRate));
+    auto blendMode = binary.find(header + '\0');
+    ASSERT_NE(blendMode, std::string::npos);
+    std::string corrupt = binary;
+    corrupt[blendMode + header.size()] = 7;
+    ASSERT_TRUE(rlottie::Animation::loadFromData(corrupt, "binary_N", "",
+                                                 false) == nullptr);
+
+    binary.resize(binary.size() / 2);
+    ASSERT_TRUE(rlottie::Animation::loadFromData(binary, "binary_N", "",
+                                                 false) == nullptr);
+}
+
+TEST_F(AnimationTest, loadFromStream) {
+    ASSERT_TRUE(animation != nullptr);
+    std::ifstream file(DEMO_DIR "mask.json", std::ios::binary);
+    auto streamed = rlottie::Animation::loadFromStream(file);
+    ASSERT_TRUE(streamed != nullptr);
+    ASSERT_EQ(streamed->toBinary(), animation->toBinary());
+
+    // a reader handing out a few bytes at a time.
+    std::string binary = animation->toBinary();
+    size_t pos = 0;
+    auto reader = [&](char *buffer, size_t size) {
+        size = std::min(std::min(size, size_t(3)), binary.size() - pos);
+        memcpy(buffer, binary.data() + pos, size);
+        pos += size;
+        return size;
+    };
+    auto loaded = rlottie::Animation::loadFromStream(reader, "stream", "", false);
+    ASSERT_TRUE(loaded != nullptr);
+    ASSERT_EQ(loaded->totalFrame(), animation->totalFrame());
+
+    std::vector<uint32_t> buffer(100 * 100);
+    std::vector<uint32_t> streamBuffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    rlottie::Surface streamSurface(streamBuffer.data(), 100, 100, 100 * 4);
+    animation->renderSync(10, surface);
+    streamed->renderSync(10, streamSurface);
+    ASSERT_EQ(buffer, streamBuffer);
+
+    // json larger than the stream buffer, handed out in small chunks so
+    // strings and keys get split across reads.
+    std::ifstream large(DEMO_DIR "loading.json", std::ios::binary);
+    std::string largeJson((std::istreambuf_iterator<char>(large)),
+                          std::istreambuf_iterator<char>());
+    ASSERT_GT(largeJson.size(), size_t(64 * 1024));
+    pos = 0;
+    auto jsonReader = [&](char *buffer, size_t size) {
+        size = std::min(std::min(size, size_t(7)), largeJson.size() - pos);
+        memcpy(buffer, largeJson.data() + pos, size);
+        pos += size;
+        return size;
+    };
+    auto chunked = rlottie::Animation::loadFromStream(jsonReader, "chunked", "", false);
+    ASSERT_TRUE(chunked != nullptr);
+    auto parsed = rlottie::Animation::loadFromData(largeJson, "parsed", "", false);
+    ASSERT_TRUE(parsed != nullptr);
+    ASSERT_EQ(chunked->toBinary(), parsed->toBinary());
+
+    std::ifstream truncated(DEMO_DIR "mask.json", std::ios::binary);
+    std::string json((std::istreambuf_iterator<char>(truncated)),
+                     std::istreambuf_iterator<char>());
+    json.resize(json.size() / 2);
+    std::istringstream half(json);
+    ASSERT_TRUE(rlottie::Animation::loadFromStream(half) == nullptr);
+}
+
+TEST_F(AnimationTest, memoryStats) {
+    ASSERT_TRUE(animation != nullptr);
+    auto stats = animation->memoryStats();
+    ASSERT_GT(stats.model, 0u);
+    ASSERT_GT(stats.paths, 0u);
+    ASSERT_LE(stats.keyframes + stats.paths + stats.modelArena + stats.images +
+                  stats.fonts,
+              stats.model);
+    ASSERT_EQ(stats.rles, 0u);
+
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    animation->setFrameCacheSize(100 * 100 * 4);
+    animation->renderSync(10, surface);
+    animation->renderTree(11, 100, 100);
+    stats = animation->memoryStats();
+    ASSERT_GT(stats.rles, 0u);
+    ASSERT_GT(stats.renderTree, 0u);
+    ASSERT_EQ(stats.frameCache, 100u * 100u * 4u);
+    ASSERT_LE(stats.rles + stats.surfaces + stats.renderTree + stats.frameCache,
+              stats.renderer);
+    ASSERT_EQ(stats.total, stats.model + stats.renderer);
+
+    auto process = rlottie::memoryStats();
+    ASSERT_GE(process.renderer, stats.renderer);
+    ASSERT_GE(process.model, stats.model);
+    ASSERT_EQ(process.total, process.model + process.renderer);
+}
+
+TEST_F(AnimationTest, imageDecoding) {
+    auto image = rlottie::Animation::loadFromFile(
+        std::string(DEMO_DIR) + "image_embedded.json", false);
+    ASSERT_TRUE(image != nullptr);
+
+    // only the encoded image is held till the layer gets drawn.
+    ASSERT_EQ(image->memoryStats().images, 0u);
+
+    std::vector<uint32_t> buffer(100 * 100);
+    std::vector<uint32_t> redecoded(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    rlottie::Surface redecodedSurface(redecoded.data(), 100, 100, 100 * 4);
+    image->renderSync(0, surface);
+    ASSERT_GT(image->memoryStats().images, 0u);
+
+    rlottie::releaseDecodedImages();
+    ASSERT_EQ(image->memoryStats().images, 0u);
+
+    image->renderSync(1, redecodedSurface);
+    image->renderSync(0, redecodedSurface);
+    ASSERT_EQ(buffer, redecoded);
+}
+
+TEST_F(AnimationTest, keyframeSeek) {
+    ASSERT_TRUE(animation != nullptr);
+    std::vector<uint32_t> buffer(100 * 100);
+    std::vector<uint32_t> freshBuffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    rlottie::Surface freshSurface(freshBuffer.data(), 100, 100, 100 * 4);
+
+    // the keyframe lookup must not depend on the frames seen before.
+    for (size_t frame = 0; frame < animation->totalFrame(); frame++)
+        animation->renderSync(frame, surface);
+    for (size_t frame : {size_t(7), size_t(25), size_t(3), size_t(20)}) {
+        animation->renderSync(frame, surface);
+        auto fresh = rlottie::Animation::loadFromFile(DEMO_DIR "mask.json", false);
+        ASSERT_TRUE(fresh != nullptr);
+        fresh->renderSync(frame, freshSurface);
+        ASSERT_EQ(buffer, freshBuffer);
+    }
+}
+
+TEST_F(AnimationTest, renderContext) {
+    ASSERT_TRUE(animation != nullptr);
+    auto context = animation->createRenderContext();
+    ASSERT_TRUE(context != nullptr);
+
+    std::vector<uint32_t> buffer(100 * 100);
+    std::vector<uint32_t> contextBuffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    rlottie::Surface contextSurface(contextBuffer.data(), 100, 100, 100 * 4);
+
+    auto first = animation->render(5, surface);
+    auto second = context->render(5, contextSurface);
+    first.get();
+    second.get();
+    ASSERT_EQ(buffer, contextBuffer);
+}
+
+TEST_F(AnimationTest, renderRange) {
+    ASSERT_TRUE(animation != nullptr);
+    std::vector<std::vector<uint32_t>> buffers(3, std::vector<uint32_t>(100 * 100));
+    std::vector<rlottie::Surface> surfaces;
+    for (auto &buffer : buffers) surfaces.emplace_back(buffer.data(), 100, 100, 100 * 4);
+
+    auto reference = rlottie::Animation::loadFromFile(std::string(DEMO_DIR) + "mask.json");
+    std::vector<uint32_t> referenceBuffer(100 * 100);
+    rlottie::Surface referenceSurface(referenceBuffer.data(), 100, 100, 100 * 4);
+
+    size_t expected = 2;
+    animation->renderRange(2, 12, surfaces,
+                           [&](size_t frameNo, const rlottie::Surface &surface) {
+        ASSERT_EQ(frameNo, expected++);
+        reference->renderSync(frameNo, referenceSurface);
+        ASSERT_EQ(0, memcmp(surface.buffer(), referenceBuffer.data(),
+                            referenceBuffer.size() * sizeof(uint32_t)));
+    });
+    ASSERT_EQ(expected, 13);
+}
+
+TEST_F(AnimationTest, renderBands) {
+    ASSERT_TRUE(animation != nullptr);
+    auto banded = rlottie::Animation::loadFromFile(std::string(DEMO_DIR) + "mask.json");
+    ASSERT_TRUE(banded != nullptr);
+    banded->setRenderBands(4);
+
+    std::vector<uint32_t> buffer(200 * 200);
+    std::vector<uint32_t> bandBuffer(200 * 200);
+    for (size_t frameNo = 0; frameNo < animation->totalFrame(); frameNo += 5) {
+        animation->renderSync(frameNo, rlottie::Surface(buffer.data(), 200, 200, 200 * 4));
+        banded->renderSync(frameNo, rlottie::Surface(bandBuffer.data(), 200, 200, 200 * 4));
+        ASSERT_EQ(buffer, bandBuffer);
+    }
+}
+
+TEST_F(AnimationTest, renderDamage) {
+    ASSERT_TRUE(animation != nullptr);
+    std::vector<uint32_t> buffer(200 * 200);
+    rlottie::Surface surface(buffer.data(), 200, 200, 200 * 4);
+    rlottie::Rect damage;
+
+    animation->renderSync(0, surface, true, &damage);
+    ASSERT_EQ(damage.w(), 200u);
+    ASSERT_EQ(damage.h(), 200u);
+
+    animation->renderSync(0, surface, true, &damage);
+    ASSERT_TRUE(damage.empty());
+
+    for (size_t frameNo = 1; frameNo < animation->totalFrame(); frameNo++) {
+        std::vector<uint32_t> prev = buffer;
+        animation->renderSync(frameNo, surface, true, &damage);
+        for (size_t y = 0; y < 200; y++) {
+            for (size_t x = 0; x < 200; x++) {
+                if (buffer[y * 200 + x] == prev[y * 200 + x]) continue;
+                ASSERT_TRUE(x >= damage.x() && x < damage.x() + damage.w());
+                ASSERT_TRUE(y >= damage.y() && y < damage.y() + damage.h());
+            }
+        }
+    }
+}
+
+TEST_F(AnimationTest, renderPartialRedraw) {
+    // the gradients of insta_camera.json are cut by the damaged area.
+    for (const char *file : {"mask.json", "insta_camera.json"}) {
+        auto full = rlottie::Animation::loadFromFile(std::string(DEMO_DIR) + file);
+        auto partial = rlottie::Animation::loadFromFile(std::string(DEMO_DIR) + file);
+        ASSERT_TRUE(full != nullptr);
+        ASSERT_TRUE(partial != nullptr);
+        partial->setPartialRedraw(true);
+
+        std::vector<uint32_t> buffer(200 * 160);
+        std::vector<uint32_t> partialBuffer(200 * 160);
+        for (size_t frameNo = 0; frameNo < full->totalFrame(); frameNo++) {
+            full->renderSync(frameNo, rlottie::Surface(buffer.data(), 200, 160, 200 * 4));
+            partial->renderSync(frameNo, rlottie::Surface(partialBuffer.data(), 200, 160, 200 * 4));
+            ASSERT_EQ(buffer, partialBuffer) << file << " frame " << frameNo;
+        }
+    }
+}
+
+TEST_F(AnimationTest, isFrameIdentical) {
+    // opacity is animated from frame 0 to 10 and then holds till the end.
+    std::string data = R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,
+        "layers":[{"ty":1,"ind":1,"ip":0,"op":30,"st":0,"sw":100,"sh":100,
+        "sc":"#ff0000","ks":{"o":{"a":1,"k":[{"t":0,"s":[0],"e":[100],
+        "i":{"x":[1],"y":[1]},"o":{"x":[0],"y":[0]}},{"t":10}]}}}]})";
+    auto hold = rlottie::Animation::loadFromData(data, "isFrameIdentical");
+    ASSERT_TRUE(hold != nullptr);
+
+    ASSERT_FALSE(hold->isFrameIdentical(4, 5));
+    ASSERT_FALSE(hold->isFrameIdentical(10, 11));
+    ASSERT_TRUE(hold->isFrameIdentical(11, 12));
+    ASSERT_TRUE(hold->isFrameIdentical(12, 29));
+
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    ASSERT_TRUE(hold->renderSync(11, surface));
+    ASSERT_FALSE(hold->renderSync(20, surface));
+    ASSERT_TRUE(hold->renderSync(5, surface));
+}
+
+TEST_F(AnimationTest, textDocumentChange) {
+    // the text switches from "A" to "B" at frame 15, the glyphs are squares
+    // at different places.
+    std::string data = R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,
+        "fonts":{"list":[{"fName":"F","fFamily":"Fam","fStyle":"Regular",
+            "ascent":75}]},
+        "chars":[{"ch":"A","size":100,"style":"Regular","w":50,"fFamily":"Fam",
+            "data":{"shapes":[{"ty":"gr","it":[{"ty":"sh","ks":{"a":0,"k":{
+            "i":[[0,0],[0,0],[0,0],[0,0]],"o":[[0,0],[0,0],[0,0],[0,0]],
+            "v":[[0,0],[20,0],[20,20],[0,20]],"c":true}}}]}]}},
+        {"ch":"B","size":100,"style":"Regular","w":50,"fFamily":"Fam",
+            "data":{"shapes":[{"ty":"gr","it":[{"ty":"sh","ks":{"a":0,"k":{
+            "i":[[0,0],[0,0],[0,0],[0,0]],"o":[[0,0],[0,0],[0,0],[0,0]],
+            "v":[[40,0],[60,0],[60,20],[40,20]],"c":true}}}]}]}}],
+        "layers":[{"ty":5,"ind":1,"ip":0,"op":30,"st":0,"nm":"text","ks":{},
+        "t":{"d":{"k":[{"s":{"s":100,"f":"F","t":"A","j":0,"tr":0,"lh":120,
+            "ls":0,"fc":[1,0,0]},"t":0},
+        {"s":{"s":100,"f":"F","t":"B","j":0,"tr":0,"lh":120,"ls":0,
+            "fc":[1,0,0]},"t":15}]},"a":[]}}]})";
+    auto text = rlottie::Animation::loadFromData(data, "textDocumentChange");
+    ASSERT_TRUE(text != nullptr);
+    ASSERT_FALSE(text->isFrameIdentical(10, 20));
+
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    text->renderSync(10, surface);
+    ASSERT_EQ(buffer[10 * 100 + 10], 0xffff0000);
+    ASSERT_EQ(buffer[10 * 100 + 50], 0u);
+
+    text->renderSync(20, surface);
+    ASSERT_EQ(buffer[10 * 100 + 10], 0u);
+    ASSERT_EQ(buffer[10 * 100 + 50], 0xffff0000);
+}
+
+TEST_F(AnimationTest, frameCache) {
+    ASSERT_TRUE(animation != nullptr);
+    auto cached = rlottie::Animation::loadFromFile(std::string(DEMO_DIR) + "mask.json");
+    ASSERT_TRUE(cached != nullptr);
+    // room for a few frames only, to exercise the eviction.
+    cached->setFrameCacheSize(4 * 100 * 100 * 4);
+
+    std::vector<uint32_t> buffer(200 * 200);
+    std::vector<uint32_t> cachedBuffer(200 * 200);
+    for (size_t loop = 0; loop < 2; loop++) {
+        for (size_t frameNo = 0; frameNo < animation->totalFrame(); frameNo += 3) {
+            rlottie::Surface surface(buffer.data(), 200, 200, 200 * 4);
+            rlottie::Surface cachedSurface(cachedBuffer.data(), 200, 200, 200 * 4);
+            surface.setDrawRegion(50, 50, 100, 100);
+            cachedSurface.setDrawRegion(50, 50, 100, 100);
+            std::fill(cachedBuffer.begin(), cachedBuffer.end(), 0xffffffff);
+            animation->renderSync(frameNo, surface);
+            cached->renderSync(frameNo, cachedSurface);
+            ASSERT_EQ(buffer, cachedBuffer);
+        }
+    }
+
+    // a cached frame clears the whole line, padding included.
+    std::vector<uint32_t> padded(210 * 200, 0xffffffff);
+    rlottie::Surface paddedSurface(padded.data(), 200, 200, 210 * 4);
+    paddedSurface.setDrawRegion(50, 50, 100, 100);
+    cached->renderSync(0, paddedSurface);
+    std::fill(padded.begin(), padded.end(), 0xffffffff);
+    cached->renderSync(0, paddedSurface);
+    ASSERT_EQ(padded[10 * 210 + 205], 0u);
+    ASSERT_EQ(padded[60 * 210 + 205], 0u);
+}
+
+TEST_F(AnimationTest, staticContentFolding) {
+    // both groups hold only a static path and have no name, they get
+    // folded into the root group with their offset applied to the path
+    // points.
+    std::string data = R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,
+        "layers":[{"ty":4,"ind":1,"ip":0,"op":30,"st":0,"nm":"layer",
+        "ks":{},"shapes":[{"ty":"gr","nm":"root","it":[
+        {"ty":"gr","it":[{"ty":"sh","ks":{"a":0,"k":{
+            "i":[[0,0],[0,0],[0,0],[0,0]],"o":[[0,0],[0,0],[0,0],[0,0]],
+            "v":[[0,0],[20,0],[20,20],[0,20]],"c":true}}},
+            {"ty":"tr","p":{"a":0,"k":[50,0]}}]},
+        {"ty":"gr","it":[{"ty":"sh","ks":{"a":0,"k":{
+            "i":[[0,0],[0,0],[0,0],[0,0]],"o":[[0,0],[0,0],[0,0],[0,0]],
+            "v":[[0,40],[20,40],[20,60],[0,60]],"c":true}}},
+            {"ty":"tr","p":{"a":0,"k":[0,0]}}]},
+        {"ty":"fl","nm":"fill","c":{"a":0,"k":[1,0,0,1]},"o":{"a":0,"k":100}},
+        {"ty":"tr"}]}]}]})";
+    auto folded = rlottie::Animation::loadFromData(data, "staticContentFolding");
+    ASSERT_TRUE(folded != nullptr);
+
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    folded->renderSync(0, surface);
+    ASSERT_EQ(buffer[10 * 100 + 60], 0xffff0000);
+    ASSERT_EQ(buffer[50 * 100 + 10], 0xffff0000);
+    ASSERT_EQ(buffer[10 * 100 + 10], 0u);
+
+    auto loaded = rlottie::Animation::loadFromData(folded->toBinary(), "", "", false);
+    ASSERT_TRUE(loaded != nullptr);
+    std::vector<uint32_t> binaryBuffer(100 * 100);
+    rlottie::Surface binarySurface(binaryBuffer.data(), 100, 100, 100 * 4);
+    loaded->renderSync(0, binarySurface);
+    ASSERT_EQ(buffer, binaryBuffer);
+
+    // the paint is kept, so it can still be changed.
+    auto green = rlottie::Animation::loadFromData(data, "staticContentFolding");
+    ASSERT_TRUE(green != nullptr);
+    green->setValue<rlottie::Property::FillColor>("layer.root.fill",
+                                                  rlottie::Color(0, 1, 0));
+    green->renderSync(0, surface);
+    ASSERT_EQ(buffer[50 * 100 + 10], 0xff00ff00);
+}
+
+TEST_F(AnimationTest, staticContentFoldingKeyPath) {
+    // "g" holds only a static path but has a name, its transform can still
+    // be changed.
+    std::string data = R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,
+        "layers":[{"ty":4,"ind":1,"ip":0,"op":30,"st":0,"nm":"layer",
+        "ks":{},"shapes":[{"ty":"gr","nm":"g","it":[{"ty":"sh","ks":{"a":0,
+            "k":{"i":[[0,0],[0,0],[0,0],[0,0]],"o":[[0,0],[0,0],[0,0],[0,0]],
+            "v":[[10,10],[30,10],[30,30],[10,30]],"c":true}}},
+            {"ty":"tr","p":{"a":0,"k":[0,0]}}]},
+        {"ty":"fl","nm":"fill","c":{"a":0,"k":[1,0,0,1]},"o":{"a":0,"k":100}}]}]})";
+    auto moved = rlottie::Animation::loadFromData(data, "staticContentFoldingKeyPath");
+    ASSERT_TRUE(moved != nullptr);
+    moved->setValue<rlottie::Property::TrPosition>("layer.g", rlottie::Point(50, 50));
+
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    moved->renderSync(0, surface);
+    ASSERT_EQ(buffer[70 * 100 + 70], 0xffff0000);
+    ASSERT_EQ(buffer[20 * 100 + 20], 0u);
+
+    // without the names the group is folded and renders in place.
+    rlottie::LoadOptions options;
+    options.noDynamicProperties = true;
+    auto lean = rlottie::Animation::loadFromData(data, "staticContentFoldingKeyPath",
+                                                 "", options);
+    ASSERT_TRUE(lean != nullptr);
+    std::fill(buffer.begin(), buffer.end(), 0);
+    lean->renderSync(0, surface);
+    ASSERT_EQ(buffer[20 * 100 + 20], 0xffff0000);
+    ASSERT_EQ(buffer[70 * 100 + 70], 0u);
+}
+
+TEST_F(AnimationTest, noDynamicProperties) {
+    std::string data = R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,
+        "assets":[{"id":"unused","layers":[{"ty":3,"ind":1,"ip":0,"op":30,
+            "st":0,"nm":"unused null layer","ks":{}}]}],
+        "markers":[{"cm":"intro","tm":0,"dr":10}],
+        "layers":[{"ty":4,"ind":1,"ip":0,"op":30,"st":0,"nm":"a long layer name",
+        "ks":{},"shapes":[{"ty":"rc","nm":"rect","p":{"a":0,"k":[50,50]},
+            "s":{"a":0,"k":[40,40]},"r":{"a":0,"k":0}},
+        {"ty":"fl","nm":"fill","c":{"a":0,"k":[1,0,0,1]},"o":{"a":0,"k":100}}]}]})";
+    auto full = rlottie::Animation::loadFromData(data, "noDynamicProperties");
+    ASSERT_TRUE(full != nullptr);
+    ASSERT_EQ(full->markers().size(), 1u);
+    ASSERT_EQ(std::get<0>(full->layers()[0]), "a long layer name");
+
+    rlottie::LoadOptions options;
+    options.noDynamicProperties = true;
+    auto lean = rlottie::Animation::loadFromData(data, "noDynamicProperties", "",
+                                                 options);
+    ASSERT_TRUE(lean != nullptr);
+    ASSERT_TRUE(lean->markers().empty());
+    ASSERT_EQ(std::get<0>(lean->layers()[0]), "");
+
+    std::vector<uint32_t> fullBuffer(100 * 100);
+    rlottie::Surface fullSurface(fullBuffer.data(), 100, 100, 100 * 4);
+    full->renderSync(0, fullSurface);
+    ASSERT_EQ(fullBuffer[50 * 100 + 50], 0xffff0000);
+
+    // the names are gone, the keypath finds nothing and the color stays.
+    lean->setValue<rlottie::Property::FillColor>("a long layer name.fill",
+                                                 rlottie::Color(0, 1, 0));
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    lean->renderSync(0, surface);
+    ASSERT_EQ(buffer, fullBuffer);
+
+    auto loaded = rlottie::Animation::loadFromData(lean->toBinary(), "", "", false);
+    ASSERT_TRUE(loaded != nullptr);
+    std::fill(buffer.begin(), buffer.end(), 0);
+    loaded->renderSync(0, surface);
+    ASSERT_EQ(buffer, fullBuffer);
+
+    // the full model is cached apart from the lean one.
+    auto again = rlottie::Animation::loadFromData(data, "noDynamicProperties");
+    ASSERT_TRUE(again != nullptr);
+    ASSERT_EQ(again->markers().size(), 1u);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "rlottie_capi.h"
+#include <cstdio>
+#include <vector>
 
 class AnimationCApiTest : public ::testing::Test {
 public:
@@ -32,3 +34,91 @@ TEST_F(AnimationCApiTest, loadFromFile) {
     ASSERT_EQ(width, 500);
     ASSERT_EQ(height, 500);
 }
+
+TEST_F(AnimationCApiTest, isFrameIdentical) {
+    ASSERT_EQ(lottie_animation_is_frame_identical(animation, 0, 0), 1);
+    ASSERT_EQ(lottie_animation_is_frame_identical(animationInvalid, 0, 1), 0);
+}
+
+TEST_F(AnimationCApiTest, frameCache) {
+    std::vector<uint32_t> buffer(100 * 100);
+    std::vector<uint32_t> cachedBuffer(100 * 100);
+    lottie_animation_render(animation, 10, buffer.data(), 100, 100, 100 * 4);
+    lottie_animation_set_frame_cache_size(animation, 2 * 100 * 100 * 4);
+    lottie_animation_render(animation, 10, cachedBuffer.data(), 100, 100, 100 * 4);
+    lottie_animation_render(animation, 5, cachedBuffer.data(), 100, 100, 100 * 4);
+    lottie_animation_render(animation, 10, cachedBuffer.data(), 100, 100, 100 * 4);
+    ASSERT_EQ(buffer, cachedBuffer);
+    lottie_animation_set_frame_cache_size(animationInvalid, 100);
+}
+
+static void inlineExecutor(void *data, Lottie_Task_Run run, void *task)
+{
+    (*static_cast<size_t *>(data))++;
+    run(task);
+}
+
+TEST_F(AnimationCApiTest, executor) {
+    std::vector<uint32_t> buffer(100 * 100);
+    std::vector<uint32_t> asyncBuffer(100 * 100);
+    lottie_animation_render(animation, 10, buffer.data(), 100, 100, 100 * 4);
+
+    size_t tasks = 0;
+    lottie_configure_executor(inlineExecutor, &tasks);
+    lottie_animation_render_async(animation, 10, asyncBuffer.data(), 100, 100, 100 * 4);
+    lottie_animation_render_flush(animation);
+    lottie_configure_executor(nullptr, nullptr);
+
+    ASSERT_GT(tasks, 0u);
+    ASSERT_EQ(buffer, asyncBuffer);
+}
+
+TEST_F(AnimationCApiTest, binary) {
+    std::string path = DEMO_DIR;
+    path += "mask_capi.rlm";
+    ASSERT_EQ(lottie_animation_save_binary(animation, path.c_str()), 1);
+    ASSERT_EQ(lottie_animation_save_binary(animationInvalid, path.c_str()), 0);
+
+    Lottie_Animation *loaded = lottie_animation_from_file(path.c_str());
+    std::remove(path.c_str());
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(lottie_animation_get_totalframe(loaded),
+              lottie_animation_get_totalframe(animation));
+    lottie_animation_destroy(loaded);
+
+    const char garbage[] = "\x89RLM garbage";
+    ASSERT_FALSE(lottie_animation_from_binary(garbage, sizeof(garbage), NULL));
+}
+
+static size_t readFile(void *data, char *buffer, size_t size)
+{
+    return fread(buffer, 1, size, static_cast<FILE *>(data));
+}
+
+TEST_F(AnimationCApiTest, fromReader) {
+    FILE *file = fopen(DEMO_DIR "mask.json", "rb");
+    ASSERT_TRUE(file);
+    Lottie_Animation *loaded = lottie_animation_from_reader(readFile, file, NULL, NULL);
+    fclose(file);
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(lottie_animation_get_totalframe(loaded),
+              lottie_animation_get_totalframe(animation));
+    lottie_animation_destroy(loaded);
+
+    ASSERT_FALSE(lottie_animation_from_reader(NULL, NULL, NULL, NULL));
+}
+
+TEST_F(AnimationCApiTest, memoryStats) {
+    std::vector<uint32_t> buffer(100 * 100);
+    lottie_animation_render(animation, 10, buffer.data(), 100, 100, 100 * 4);
+
+    Lottie_Memory_Stats stats;
+    lottie_animation_get_memory_stats(animation, &stats);
+    ASSERT_GT(stats.model, 0u);
+    ASSERT_GT(stats.rles, 0u);
+    ASSERT_EQ(stats.total, stats.model + stats.renderer);
+
+    Lottie_Memory_Stats process;
+    lottie_memory_stats(&process);
+    ASSERT_GE(process.total, stats.total);
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "lottiemodel.h"
+
+using namespace rlottie::internal;
+
+class LottieModelTest : public ::testing::Test {
+public:
+    VArenaAlloc allocator{2048};
+};
+
+TEST_F(LottieModelTest, easingTables) {
+    VInterpolator easeInOut(0.42f, 0, 0.58f, 1);
+    VInterpolator overshoot(0.3f, -0.5f, 0.7f, 1.5f);
+    model::EasingTables tables;
+
+    // the table holds the progress the interpolator gives for each frame.
+    for (auto interpolator : {&easeInOut, &overshoot}) {
+        for (float start : {0.f, 7.f, -12.f}) {
+            for (float length : {1.f, 2.f, 13.f, 60.f, 512.f}) {
+                model::KeyFrames<float, void>::Frame direct;
+                direct.start_ = start;
+                direct.end_ = start + length;
+                direct.interpolator_ = interpolator;
+                auto eased = direct;
+                eased.easing_ = tables.table(allocator, interpolator,
+                                             direct.start_, direct.end_);
+                ASSERT_TRUE(eased.easing_ != nullptr);
+
+                for (int frameNo = int(start); frameNo < int(start + length);
+                     frameNo++)
+                    ASSERT_EQ(eased.progress(frameNo), direct.progress(frameNo));
+            }
+        }
+    }
+
+    // keyframes of the same length and easing share the table.
+    ASSERT_EQ(tables.table(allocator, &easeInOut, 3, 16),
+              tables.table(allocator, &easeInOut, 0, 13));
+
+    VInterpolator linear(0.25f, 0.25f, 0.75f, 0.75f);
+    ASSERT_TRUE(tables.table(allocator, &linear, 0, 10) == nullptr);
+    ASSERT_TRUE(tables.table(allocator, &easeInOut, 0.5f, 10) == nullptr);
+    ASSERT_TRUE(tables.table(allocator, &easeInOut, 0, 513) == nullptr);
+}
+
+TEST_F(LottieModelTest, motionPathTables) {
+    // start, end and the tangents relative to them.
+    const VPointF curves[][4] = {
+        {{0, 0}, {100, 0}, {0, 100}, {0, 100}},
+        {{0, 0}, {300, 300}, {300, 0}, {-300, 0}},
+        {{10, 10}, {20, 10}, {200, 200}, {-200, 200}},
+        {{0, 0}, {2000, 0}, {0, 1500}, {0, -1500}},
+    };
+
+    // the position found through the arc length table stays within a
+    // tenth of a pixel of the one found by bisecting the curve.
+    const float tolerance = 0.1f;
+    for (const auto &curve : curves) {
+        model::Value<VPointF, model::Position> exact;
+        exact.start_ = curve[0];
+        exact.end_ = curve[1];
+        exact.outTangent_ = curve[2];
+        exact.inTangent_ = curve[3];
+        exact.hasTangent_ = true;
+        exact.cache();
+        auto table = exact;
+        table.setupTables(allocator);
+        ASSERT_TRUE(table.lengths_ != nullptr);
+
+        for (int i = 0; i <= 1000; i++) {
+            auto t = i / 1000.f;
+            auto d = table.at(t) - exact.at(t);
+            ASSERT_LE(std::sqrt(d.x() * d.x() + d.y() * d.y()), tolerance);
+        }
+        ASSERT_FLOAT_EQ(table.at(0).x(), exact.start_.x());
+        ASSERT_FLOAT_EQ(table.at(0).y(), exact.start_.y());
+        ASSERT_FLOAT_EQ(table.at(1).x(), exact.end_.x());
+        ASSERT_FLOAT_EQ(table.at(1).y(), exact.end_.y());
+    }
+}